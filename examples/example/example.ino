@@ -23,6 +23,9 @@ struct ledStrip led_strip;
 /* Led array */
 CRGB leds[NUM_LEDS];
 
+/* Precomputed palette colors. 64 entries use 192 bytes of ram */
+CRGB palette_lut[64];
+
 void setup()
 {
   pinMode(AUDIO_PIN, INPUT);
@@ -45,6 +48,7 @@ void setup()
   
   effect_mgr.add_effect(led_strip, bassEffect);
 
+  bassEffect.set_palette_lut(palette_lut, 64);
   bassEffect.set_color_palette(blueBass_p);
 }
 
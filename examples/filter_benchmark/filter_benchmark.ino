@@ -0,0 +1,122 @@
+#include <SubEffects.h>
+
+#define BENCHMARK_ROUNDS 1000
+#define BATCH_LEDS 60
+#define BATCH_ROUNDS 100
+
+/*
+ * Compares the time per call of EWMAtest's float pow() 
+ * with exp_smoother's fixed point exp table.
+ * Both settle on the input over the rounds, so the printed outputs should match.
+ *
+ * Then times the templated filters for each sample type
+ * & the batch filters per led.
+ * Cycles are derived from micros() & assume a 16 MHz clock.
+ */
+
+EWMAtest float_filter(0.01F);
+exp_smoother fixed_filter(0.01F);
+
+/* Inputs are read from volatile so the calls aren't optimized out */
+volatile uint16_t input = 0;
+volatile uint16_t time_delta = 16;
+
+/**
+ * @brief Prints the cycles per calc() call of the filter
+ */
+template <typename FILTER, typename T>
+void benchmark_filter(const __FlashStringHelper *name, FILTER &filter)
+{
+    uint32_t start = micros();
+    T result = 0;
+
+    for (uint16_t i = 0; i < BENCHMARK_ROUNDS; i++)
+        result += filter.calc((T) input);
+
+    start = micros() - start;
+    INFO(name, F(": "), start * 16 / BENCHMARK_ROUNDS, F(" cycles  "), (int32_t) result);
+}
+
+moving_average<uint8_t, 8> average_u8;
+moving_average<int16_t, 8> average_i16;
+moving_average<float, 8> average_float;
+shift_ewma<uint8_t, 4> ewma_u8;
+shift_ewma<int16_t, 4> ewma_i16;
+shift_ewma<float, 4> ewma_float;
+slew_limiter<uint8_t> slew_u8(3);
+slew_limiter<int16_t> slew_i16(3);
+slew_limiter<float> slew_float(3);
+
+CRGB batch_state[BATCH_LEDS];
+CRGB batch_input[BATCH_LEDS];
+
+/**
+ * @brief Prints the cycles per led of ewma_array() & decay_array()
+ */
+void benchmark_batch()
+{
+    uint32_t ewma_time = 0;
+    uint32_t decay_time = 0;
+
+    for (uint8_t i = 0; i < BATCH_LEDS; i++)
+        batch_input[i] = CRGB(random8(), random8(), random8());
+
+    uint32_t start = micros();
+    for (uint16_t i = 0; i < BATCH_ROUNDS; i++)
+        ewma_array((uint8_t *) batch_state, (const uint8_t *) batch_input, BATCH_LEDS * sizeof(CRGB), 32);
+    ewma_time = micros() - start;
+
+    start = micros();
+    for (uint16_t i = 0; i < BATCH_ROUNDS; i++)
+        decay_array((uint8_t *) batch_state, BATCH_LEDS * sizeof(CRGB), 250);
+    decay_time = micros() - start;
+
+    INFO(F("ewma_array: "), ewma_time * 16 / ((uint32_t) BATCH_ROUNDS * BATCH_LEDS), 
+         F(" cycles/led  decay_array: "), decay_time * 16 / ((uint32_t) BATCH_ROUNDS * BATCH_LEDS), F(" cycles/led"));
+}
+
+void setup()
+{
+    Serial.begin(38400);
+    delay(500);
+    DEBUG(F("Filter benchmark"));
+}
+
+void loop()
+{
+    uint32_t start = 0;
+    uint32_t float_time = 0;
+    uint32_t fixed_time = 0;
+    float float_result = 0;
+    int16_t fixed_result = 0;
+
+    input = random8();
+
+    /* EWMAtest reads the interval from millis(). Inside the loop it's ~0 ms, which costs the same pow() */
+    delay(time_delta);
+    start = micros();
+    for (uint16_t i = 0; i < BENCHMARK_ROUNDS; i++)
+        float_result = float_filter.calc(input);
+    float_time = micros() - start;
+
+    start = micros();
+    for (uint16_t i = 0; i < BENCHMARK_ROUNDS; i++)
+        fixed_result = fixed_filter.calc(input, time_delta);
+    fixed_time = micros() - start;
+
+    /* 16 cycles per us at 16 MHz */
+    INFO(F("EWMAtest: "), float_time * 16 / BENCHMARK_ROUNDS, F(" cycles  exp_smoother: "),
+         fixed_time * 16 / BENCHMARK_ROUNDS, F(" cycles"));
+    INFO(F("input: "), input, F("  EWMAtest: "), (int16_t) float_result, F("  exp_smoother: "), fixed_result);
+
+    benchmark_filter<moving_average<uint8_t, 8>, uint8_t>(F("moving_average<uint8_t, 8>"), average_u8);
+    benchmark_filter<moving_average<int16_t, 8>, int16_t>(F("moving_average<int16_t, 8>"), average_i16);
+    benchmark_filter<moving_average<float, 8>, float>(F("moving_average<float, 8>"), average_float);
+    benchmark_filter<shift_ewma<uint8_t, 4>, uint8_t>(F("shift_ewma<uint8_t, 4>"), ewma_u8);
+    benchmark_filter<shift_ewma<int16_t, 4>, int16_t>(F("shift_ewma<int16_t, 4>"), ewma_i16);
+    benchmark_filter<shift_ewma<float, 4>, float>(F("shift_ewma<float, 4>"), ewma_float);
+    benchmark_filter<slew_limiter<uint8_t>, uint8_t>(F("slew_limiter<uint8_t>"), slew_u8);
+    benchmark_filter<slew_limiter<int16_t>, int16_t>(F("slew_limiter<int16_t>"), slew_i16);
+    benchmark_filter<slew_limiter<float>, float>(F("slew_limiter<float>"), slew_float);
+    benchmark_batch();
+}
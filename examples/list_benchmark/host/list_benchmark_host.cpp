@@ -0,0 +1,65 @@
+/*
+ * Host micro-benchmark of sl_list::handler at large node counts.
+ * Times append, find & remove (tail first) in ns per operation.
+ *
+ * Build from this directory:
+ *   g++ -O2 -std=gnu++11 -Ishim -I../../../src list_benchmark_host.cpp -o list_benchmark_host
+ *
+ * Single linked nodes:
+ *   add -DNODE_T="sl_list::node<int>" -DHANDLER_T="sl_list::handler<int>"
+ *
+ * For the list before the owner tags & tail pointer, point -I at a source tree 
+ * with the old singly_linked_list.h & build with the single linked node types.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "utils/data_types/singly_linked_list.h"
+
+#ifndef NODE_T
+#define NODE_T sl_list::dl_node<int>
+#define HANDLER_T sl_list::handler<int, sl_list::dl_node<int>>
+#endif
+
+typedef std::chrono::steady_clock::time_point time_point;
+
+void set_terminal_color(debug_level_t, bool) {}
+
+static double ns_per_operation(time_point start, time_point end, int n)
+{
+    return std::chrono::duration<double, std::nano>(end - start).count() / n;
+}
+
+int main()
+{
+    for (int n : {100, 1000, 10000})
+    {
+        std::vector<NODE_T> nodes(n);
+        std::vector<int> payload(n);
+        HANDLER_T list;
+        volatile int found = 0;
+
+        for (int i = 0; i < n; i++)
+            nodes[i].data = &payload[i];
+
+        time_point t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < n; i++)
+            list.append(&nodes[i]);
+
+        time_point t1 = std::chrono::steady_clock::now();
+        for (int i = 0; i < n; i++)
+            found += list.find(&nodes[i]) != nullptr;
+
+        time_point t2 = std::chrono::steady_clock::now();
+        for (int i = n - 1; i >= 0; i--)
+            list.remove(&nodes[i]);
+
+        time_point t3 = std::chrono::steady_clock::now();
+
+        printf("n=%5d append %8.1f ns  find %8.1f ns  remove %8.1f ns\n", n,
+               ns_per_operation(t0, t1, n), ns_per_operation(t1, t2, n), ns_per_operation(t2, t3, n));
+    }
+
+    return 0;
+}
@@ -0,0 +1,29 @@
+/*
+ * Minimal Arduino.h for building the list benchmark on the host.
+ * Debug output is discarded.
+ */
+
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+#define HEX 16
+
+struct host_serial
+{
+    template <class T> void print(T) {}
+    template <class T> void print(T, int) {}
+    template <class T> void println(T) {}
+    template <class T> void println(T, int) {}
+    void println() {}
+    void flush() {}
+};
+
+static host_serial Serial;
+
+#endif
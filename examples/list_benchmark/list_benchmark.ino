@@ -0,0 +1,71 @@
+#include <FastLED.h>
+#include <SubEffects.h>
+
+/*
+ * Times sl_list operations with many nodes.
+ * Set CONF_ENABLE_INFO to 0 in config.h, since remove() logs every removal.
+ */
+#define NODE_COUNT 64
+
+typedef sl_list::handler<uint8_t> singly_list;
+typedef sl_list::handler<uint8_t, sl_list::dl_node<uint8_t>> doubly_list;
+
+uint8_t payload[NODE_COUNT];
+
+template <typename LIST, typename NODE>
+void benchmark(const __FlashStringHelper *name, NODE *nodes)
+{
+    LIST list;
+    uint32_t start = 0;
+    uint32_t append_time = 0;
+    uint32_t find_time = 0;
+    uint32_t remove_time = 0;
+    uint8_t found = 0;
+
+    for (uint16_t i = 0; i < NODE_COUNT; i++)
+        nodes[i].data = &payload[i];
+
+    start = micros();
+    for (uint16_t i = 0; i < NODE_COUNT; i++)
+        list.append(&nodes[i]);
+    append_time = micros() - start;
+
+    start = micros();
+    for (uint16_t i = 0; i < NODE_COUNT; i++)
+        found += list.find(&nodes[i]) != nullptr;
+    find_time = micros() - start;
+
+    /* Tail first. Worst case for the singly linked list */
+    start = micros();
+    for (int16_t i = NODE_COUNT - 1; i >= 0; i--)
+        list.remove(&nodes[i]);
+    remove_time = micros() - start;
+
+    Serial.print(name);
+    Serial.print(F(" nodes: "));
+    Serial.print(found);
+    Serial.print(F(" append: "));
+    Serial.print(append_time);
+    Serial.print(F(" us find: "));
+    Serial.print(find_time);
+    Serial.print(F(" us remove: "));
+    Serial.print(remove_time);
+    Serial.println(F(" us"));
+}
+
+sl_list::node<uint8_t> singly_nodes[NODE_COUNT];
+sl_list::dl_node<uint8_t> doubly_nodes[NODE_COUNT];
+
+void setup()
+{
+    Serial.begin(38400);
+    delay(500);
+    DEBUG(F("sl_list benchmark"));
+}
+
+void loop()
+{
+    benchmark<singly_list>(F("node   "), singly_nodes);
+    benchmark<doubly_list>(F("dl_node"), doubly_nodes);
+    delay(1000);
+}
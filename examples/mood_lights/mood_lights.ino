@@ -25,7 +25,19 @@ public:
     CHSV target_color = CHSV(random8(), 255, 0);
     CHSV current_color;
 
-    virtual bool update()
+    /* '+' and '-' over serial change the fade speed */
+    virtual bool on_event(const event &e)
+    {
+        if (e.data == '+')
+            fade_speed = qadd8(fade_speed, 1);
+        else if (e.data == '-' && fade_speed > 1)
+            fade_speed--;
+
+        DEBUG(F("fade speed: "), fade_speed);
+        return 0;
+    }
+
+    virtual bool update(const frame_context &context)
     {
         if (fade_progress == 255)
         {
@@ -34,15 +46,11 @@ public:
             DEBUG(F("new hue: "), target_color.hue);
         }
 
-        EVERY_N_MILLIS(1000 / 60)
-        {
-            fade_progress = qadd8(fade_progress, fade_speed);
-            current_color = blend(current_color, target_color, fade_progress); 
-            fill_solid(&led_array[0], led_array.size(), current_color);
-            return 1;
-        }
-
-        return 0;
+        /* led_manager runs this at 60 fps */
+        fade_progress = qadd8(fade_progress, fade_speed);
+        current_color = blend(current_color, target_color, fade_progress); 
+        fill_solid(&led_array[0], led_array.size(), current_color);
+        return 1;
     }
 
 };
@@ -58,7 +66,7 @@ void setup()
     delay(500);
     DEBUG(F("Mood lights example"));
 
-    FastLED.addLeds<LED_CHIPSET, DATA_PIN, COLOR_ORDER>(&leds[0], NUM_LEDS); // GRB ordering is typical
+    CLEDController &controller = FastLED.addLeds<LED_CHIPSET, DATA_PIN, COLOR_ORDER>(&leds[0], NUM_LEDS); // GRB ordering is typical
     
     /* 
      * Conflicts with subeffect's way of updating the effects
@@ -67,13 +75,26 @@ void setup()
     FastLED.setMaxRefreshRate(0);
     FastLED.setDither(0);
 
-    effect_mgr.add_led_strip(led_strip, &leds[0], NUM_LEDS);
+    /* Strip with own controller is pushed only when its pixels change */
+    effect_mgr.add_led_strip(led_strip, controller);
     effect_mgr.add_effect(led_strip, mood_lights_obj);
+    mood_lights_obj.subscribe(event_serial_command);
+    effect_mgr.set_frame_rate(60);
 
     FastLED.setBrightness(10);
 }
 
+/* Called by the Arduino core between loop() calls when serial data is available */
+void serialEvent()
+{
+    while (Serial.available())
+        effect_mgr.post_event(event_serial_command, Serial.read());
+}
+
 void loop()
 {
     effect_mgr.update();
+
+    /* Sleep until the next frame instead of spinning */
+    effect_mgr.idle();
 }
\ No newline at end of file
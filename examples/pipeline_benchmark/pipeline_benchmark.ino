@@ -0,0 +1,81 @@
+#include <FastLED.h>
+#include <SubEffects.h>
+
+#define NUM_LEDS 58
+#define DATA_PIN 6
+#define LED_CHIPSET WS2812B
+#define COLOR_ORDER GRB
+
+#define SAMPLE_RATE 800
+#define BENCHMARK_ROUNDS 1000
+
+led_manager effect_mgr;
+
+ledStrip led_strip;
+
+CRGB leds[NUM_LEDS];
+
+/* Post processed pixels which are pushed to the leds */
+CRGB output_leds[NUM_LEDS];
+
+/*
+ * Deterministic test signal instead of the adc.
+ * 55 Hz bass line, 440 Hz tone, some noise & a kick every 500 ms
+ */
+synthetic_audio_source test_signal(SAMPLE_RATE);
+
+/* colorBass reads its samples from the test signal at full speed */
+colorBass bass_effect(test_signal);
+
+void setup()
+{
+    pinMode(DATA_PIN, OUTPUT);
+
+    Serial.begin(38400);
+    delay(500);
+    DEBUG(F("Pipeline benchmark"));
+
+    test_signal.add_tone(55, 60);
+    test_signal.add_tone(440, 20);
+    test_signal.set_noise(10);
+    test_signal.set_kick(500, 100);
+
+    CLEDController &controller = FastLED.addLeds<LED_CHIPSET, DATA_PIN, COLOR_ORDER>(&leds[0], NUM_LEDS);
+    FastLED.setMaxRefreshRate(0);
+    FastLED.setDither(0);
+
+    /* Post processing needs the strip's own controller */
+    effect_mgr.add_led_strip(led_strip, controller);
+    effect_mgr.add_effect(led_strip, bass_effect);
+    bass_effect.set_color_palette(blueBass_p);
+
+    /* Gamma, brightness & current limit in one pass. Cost per led: post_process avg / NUM_LEDS */
+    led_strip.enable_post_processing(&output_leds[0], NUM_LEDS);
+    led_strip.set_gamma_correction(1);
+    led_strip.set_brightness(128);
+    led_strip.set_current_limit(500);
+}
+
+void loop()
+{
+    uint32_t start = 0;
+    uint32_t elapsed = 0;
+    uint32_t slowest = 0;
+    uint32_t total = 0;
+
+    for (uint16_t i = 0; i < BENCHMARK_ROUNDS; i++)
+    {
+        start = micros();
+        effect_mgr.update();
+        elapsed = micros() - start;
+
+        total += elapsed;
+        if (elapsed > slowest)
+            slowest = elapsed;
+    }
+
+    INFO(F("update() avg: "), total / BENCHMARK_ROUNDS, F(" us  max: "), slowest, F(" us"));
+
+    /* Per stage breakdown. Set CONF_ENABLE_PROFILER to 1 in config.h */
+    effect_mgr.print_profile();
+}
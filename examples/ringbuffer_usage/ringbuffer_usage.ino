@@ -18,42 +18,15 @@ ledStrip led_strip;
 
 CRGB leds[NUM_LEDS];
 
+/*
+ * Runs the ringbuffer tests one step per frame.
+ * Coroutine macros keep track of where the test continues on the next update()
+ */
 class test_ringbuffer : public audioMode
 {
 private:
-    uint8_t test_state = 0;
     uint8_t test_counter = 0;
 
-    void test_ringbuffer_push()
-    {
-        CRGB color;
-
-        if (test_counter == 255)
-        {
-            INFO(F("Test rinbuffer_push() done"));
-            test_counter = 0;
-            test_state++;
-            return;
-        }
-
-        color = CHSV(random(), 255, 255);
-        r_buffer.push(color);
-        test_counter++;
-    }
-
-    void test_ringbuffer_pop()
-    {
-        if (test_counter == 255)
-        {
-            INFO(F("Test rinbuffer_pop() done"));
-            test_counter = 0;
-            test_state++;
-            return;
-        }
-        r_buffer.pop();
-        test_counter++;
-    }
-
     virtual void on_resize() override
     {
         r_buffer.resize(&led_array[0], led_array.size());
@@ -65,33 +38,32 @@ public:
     test_ringbuffer() = default;
     ~test_ringbuffer() = default;
 
-    virtual bool update()
+    virtual bool update(const frame_context &context)
     {
-        switch (test_state)
+        EFFECT_BEGIN();
+
+        for (test_counter = 0; test_counter < 255; test_counter++)
+        {
+            r_buffer.push(CRGB(CHSV(random(), 255, 255)));
+            EFFECT_YIELD(1);
+        }
+        INFO(F("Test rinbuffer_push() done"));
+
+        for (test_counter = 0; test_counter < 255; test_counter++)
         {
-        case 0:
-            test_ringbuffer_push();
-            delay(5);
-            break;
-
-        case 1:
-            test_ringbuffer_pop();
-            delay(5);
-            break;
-
-        case 2:
-            test_ringbuffer_push();
-            delay(5);
-            break;
-
-
-        default:
-            delay(5000);
-            INFO(F("Tests done"));
-            break;
+            r_buffer.pop();
+            EFFECT_YIELD(1);
         }
+        INFO(F("Test rinbuffer_pop() done"));
 
-        return 1;
+        for (test_counter = 0; test_counter < 255; test_counter++)
+        {
+            r_buffer.push(CRGB(CHSV(random(), 255, 255)));
+            EFFECT_YIELD(1);
+        }
+        INFO(F("Tests done"));
+
+        EFFECT_END(1);
     }
 };
 
@@ -122,6 +94,9 @@ void setup()
     effect_mgr.add_effect(led_strip, test_ringbuffer_obj, &leds[0], &leds[20]);
     effect_mgr.add_effect(led_strip, test_ringbuffer_obj2, &leds[21], &leds[NUM_LEDS]);
 
+    /* One test step every 5 ms */
+    effect_mgr.set_frame_rate(200);
+
     FastLED.setBrightness(10);
 }
 
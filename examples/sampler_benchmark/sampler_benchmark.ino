@@ -0,0 +1,82 @@
+#include <FastLED.h>
+#include <SubEffects.h>
+
+#define NUM_LEDS 58
+#define DATA_PIN 6
+#define LED_CHIPSET WS2812B
+#define COLOR_ORDER GRB
+
+#define FRAME_RATE 60
+#define BENCHMARK_TIME_MS 10000
+
+/*
+ * Counts the audio samples lost to led output.
+ * Runs colorBass on the adc first with unsynchronized output, 
+ * then with led_manager::set_sampler_sync().
+ * Corrupted windows are led pushes which blocked the sampling isr 
+ * for longer than a sample period while a window was filling.
+ *
+ * Late samples need CONF_SAMPLER_STATS set to 1 in config.h,
+ * the frame clock needs CONF_ENABLE_FRAME_CLOCK set to 1
+ */
+
+led_manager effect_mgr;
+
+ledStrip led_strip;
+
+CRGB leds[NUM_LEDS];
+
+colorBass bass_effect;
+
+void run_benchmark(bool sampler_sync)
+{
+    uint32_t start = millis();
+    uint32_t frames = effect_mgr.get_frame_number();
+
+    effect_mgr.set_sampler_sync(sampler_sync);
+    effect_mgr.reset_sampler_stats();
+
+    while (millis() - start < BENCHMARK_TIME_MS)
+    {
+        effect_mgr.update();
+        effect_mgr.idle();
+    }
+
+    frames = effect_mgr.get_frame_number() - frames;
+
+    INFO(F("sampler sync: "), sampler_sync, F("  frames: "), frames);
+    INFO(F("late samples: "), effect_mgr.get_late_samples(), 
+         F("  corrupted windows: "), effect_mgr.get_corrupted_windows());
+}
+
+void setup()
+{
+    pinMode(DATA_PIN, OUTPUT);
+
+    Serial.begin(38400);
+    delay(500);
+    DEBUG(F("Sampler benchmark"));
+
+    FastLED.addLeds<LED_CHIPSET, DATA_PIN, COLOR_ORDER>(&leds[0], NUM_LEDS);
+    FastLED.setMaxRefreshRate(0);
+    FastLED.setDither(0);
+
+    effect_mgr.add_led_strip(led_strip, &leds[0], NUM_LEDS);
+    effect_mgr.add_effect(led_strip, bass_effect);
+    effect_mgr.set_frame_rate(FRAME_RATE);
+    bass_effect.set_color_palette(blueBass_p);
+}
+
+void loop()
+{
+    run_benchmark(0);
+    run_benchmark(1);
+
+    /* Frames counted on the sampling timer instead of micros() */
+    if (effect_mgr.set_frame_clock(FRAME_RATE))
+        return;
+
+    run_benchmark(1);
+    effect_mgr.set_frame_clock(0);
+    effect_mgr.set_frame_rate(FRAME_RATE);
+}
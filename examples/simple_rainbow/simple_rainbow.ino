@@ -39,7 +39,7 @@ public:
      * Note: It uses led_array to access the CRGB pixels 
      * to enable changing of the effect's pixel output range easily
      */
-    virtual bool update()
+    virtual bool update(const frame_context &context)
     {
         fill_rainbow(&led_array[0], led_array.size(), beat8(speed, 255), 10 );
         return 1;
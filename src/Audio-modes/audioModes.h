@@ -28,10 +28,55 @@
 #include "../utils/data_types/virtual_led_array.h"
 #include "../utils/data_types/singly_linked_list.h"
 #include "../utils/debug.h"
+#include "../utils/profiler.h"
+#include "../utils/blend_modes.h"
+#include "../utils/event_queue.h"
+#include "../utils/frame_context.h"
 #include "../config.h"
 
+class FFT;
+
 struct ledStrip;
 
+/**
+ * @brief Stackless coroutine (protothread) helpers for audioMode::update().
+ *      Lets an effect yield mid animation and continue from the same
+ *      point on the next call, instead of writing a state machine by hand.
+ *
+ *      bool update(const frame_context &context) override
+ *      {
+ *          EFFECT_BEGIN();
+ *
+ *          for (pixel = 0; pixel < led_array.size(); pixel++)
+ *          {
+ *              led_array[pixel] = palette_color(pixel);
+ *              EFFECT_YIELD_IF_BUDGET_SPENT(1);
+ *          }
+ *
+ *          EFFECT_END(1);
+ *      }
+ *
+ * @note Local variables don't survive a yield. Keep them as class members.
+ *       Yields can't be placed inside a switch statement or two on the same line.
+ */
+#define EFFECT_BEGIN() switch (coroutine_line) { case 0:
+
+#define EFFECT_YIELD(ret)               \
+    do {                                \
+        coroutine_line = __LINE__;      \
+        return (ret);                   \
+        case __LINE__:;                 \
+    } while (0)
+
+/* Yields only when the effect has used its work budget. See audioMode::set_work_budget() */
+#define EFFECT_YIELD_IF_BUDGET_SPENT(ret)   \
+    do {                                    \
+        if (budget_spent())                 \
+            EFFECT_YIELD(ret);              \
+    } while (0)
+
+#define EFFECT_END(ret) } coroutine_line = 0; return (ret)
+
 /**
  * @brief audioMode 
  * 
@@ -39,13 +84,73 @@ struct ledStrip;
 class audioMode
 {
     uint8_t id = 0;
-    sl_list::node<audioMode> list_node = sl_list::node<audioMode>(this, nullptr);
+    sl_list::dl_node<audioMode> list_node = sl_list::dl_node<audioMode>(this, nullptr);
+
+    /* Scheduling. update() is called every update_period frames */
+    uint8_t update_period = 1;
+    uint8_t update_countdown = 0;
+
+    /* Time update() may run before EFFECT_YIELD_IF_BUDGET_SPENT yields. 0 never yields */
+    uint16_t work_budget_us = 0;
+    uint16_t update_start_time = 0;
+
+    /* Bit n set: subscribed to event_type n */
+    uint8_t event_mask = 0;
+
+    /* 1: update() isn't called on frames. Runs only from on_event() */
+    bool event_driven = 0;
+
+    /* Low priority effects run at 1 / 2^throttle_shift of their rate under load. See led_manager::set_quality_governor() */
+    bool low_priority = 0;
+    uint8_t throttle_shift = 0;
+
+    /* Led strip the effect is on, its layer & occlusion are set by the strip */
+    friend struct ledStrip;
+
+    ledStrip *owner_strip = nullptr;
+
+    /* 
+     * Layer compositing, see ledStrip::add_layer(). 
+     * Layers render to their own buffer which is blended on the strip at layer_position
+     */
+    CRGB *layer_position = nullptr;
+    CRGB *layer_end = nullptr;
+    blend_mode layer_blend = blend_replace;
+    uint8_t layer_alpha = 255;
+    uint8_t layer_z = 0;
+
+    /* Fully covered by an opaque layer above. update() is skipped */
+    bool occluded = 0;
+
+    /* Precomputed color_palette. Palette index >> palette_lut_shift is the entry. nullptr when disabled */
+    CRGB *palette_lut = nullptr;
+    uint8_t palette_lut_shift = 0;
+
+    /**
+     * @brief Fills the palette lut from color_palette
+     * 
+     */
+    void build_palette_lut()
+    {
+        uint16_t size = 0;
+
+        if (palette_lut == nullptr)
+            return;
+
+        size = 256 >> palette_lut_shift;
+
+        for (uint16_t i = 0; i < size; i++)
+            palette_lut[i] = ColorFromPalette(color_palette, (uint8_t) (i << palette_lut_shift), 255, LINEARBLEND);
+    }
 
 protected:
     /* These are inherited */
     virtual_led_array led_array;
     CRGBPalette16 color_palette = CRGBPalette16(CRGB::Black);
 
+    /* Resume point of a coroutine style update(). 0 when not suspended */
+    uint16_t coroutine_line = 0;
+
     /* 
      * Callback function to notify the class that inherits
      * 'audioMode' about the resizing of its led_array
@@ -56,6 +161,66 @@ protected:
 
 public:
 
+    /**
+     * @brief Returns 1 when the effect renders to its own layer buffer
+     * 
+     */
+    bool is_layer() {return layer_position != nullptr;}
+
+    /**
+     * @brief Returns the layer's blend mode. See ledStrip::set_layer()
+     * 
+     */
+    blend_mode get_layer_blend() {return layer_blend;}
+
+    /**
+     * @brief Returns the layer's alpha. Grows from 0 while the effect fades in
+     * 
+     */
+    uint8_t get_layer_alpha() {return layer_alpha;}
+
+    /**
+     * @brief Returns the layer's z order. Higher is on top
+     * 
+     */
+    uint8_t get_layer_z() {return layer_z;}
+
+    /**
+     * @brief Returns 1 when an opaque layer above covers the effect. Its update() is skipped
+     * 
+     */
+    bool is_occluded() {return occluded;}
+
+    /**
+     * @brief Returns 1 when the effect hides everything below it
+     * 
+     */
+    bool is_opaque() {return layer_blend == blend_replace || (layer_blend == blend_alpha && layer_alpha == 255);}
+
+    /**
+     * @brief Returns the effect's first pixel on the led strip
+     * 
+     */
+    CRGB *get_strip_start() {return is_layer() ? layer_position : led_array.get_start();}
+
+    /**
+     * @brief Returns address one past the effect's last pixel on the led strip
+     * 
+     */
+    CRGB *get_strip_end() {return is_layer() ? layer_end : led_array.get_start() + led_array.size();}
+
+    /**
+     * @brief Returns layer buffer's pixel
+     * 
+     * @param i index from the start of the layer
+     */
+    CRGB &get_layer_pixel(uint16_t i) {return led_array[i];}
+
+#if CONF_ENABLE_PROFILER == 1
+    /* Time spent in update() */
+    profile_counter profile;
+#endif
+
     /**
      * @brief Resize effect's led array 
      * 
@@ -75,21 +240,295 @@ public:
         return 1;
     } 
 
-    sl_list::node<audioMode> &get_node() {return list_node;}
+    sl_list::dl_node<audioMode> &get_node() {return list_node;}
+
+    /**
+     * @brief Returns the led strip the effect is on, or nullptr
+     * 
+     */
+    ledStrip *get_led_strip() {return owner_strip;}
+
+    /**
+     * @brief Sets the effect's palette. Rebuilds the palette lut if one is set
+     * 
+     * @param palette 
+     */
+    void set_color_palette(const TProgmemPalette16 &palette)
+    {
+        color_palette = palette;
+        build_palette_lut();
+    }
+
+    /**
+     * @brief Precomputes the palette into the buffer, so palette_color() 
+     *      is a single read instead of ColorFromPalette()'s blending.
+     *      The lut is rebuilt only by set_color_palette()
+     * @note Lower sizes save ram, but neighbouring palette indexes share a color
+     * 
+     * @param lut buffer of size pixels. nullptr disables the lut
+     * @param size entries. Power of two, 1 - 256. 256 keeps the full palette resolution
+     * @return true on failure
+     * @return false 
+     */
+    bool set_palette_lut(CRGB *lut, uint16_t size)
+    {
+        uint8_t shift = 8;
+
+        if (lut == nullptr)
+        {
+            palette_lut = nullptr;
+            return 0;
+        }
+
+        if (size == 0 || size > 256 || (size & (size - 1)))
+        {
+            ERROR(F("Palette lut size has to be a power of two up to 256. Size: "), size);
+            return 1;
+        }
+
+        while (size > 1)
+        {
+            size >>= 1;
+            shift--;
+        }
+
+        palette_lut = lut;
+        palette_lut_shift = shift;
+        build_palette_lut();
+        return 0;
+    }
+
+    /**
+     * @brief Returns the palette's color. Same as ColorFromPalette() with LINEARBLEND, 
+     *      read from the palette lut when one is set.
+     *      Lut colors are scaled like ColorFromPalette() scales brightness
+     * 
+     * @param index position in the palette
+     * @param brightness 
+     * @return CRGB 
+     */
+    CRGB palette_color(uint8_t index, uint8_t brightness = 255)
+    {
+        CRGB color;
+
+        if (palette_lut == nullptr)
+            return ColorFromPalette(color_palette, index, brightness, LINEARBLEND);
+
+        color = palette_lut[index >> palette_lut_shift];
+
+        if (brightness == 255)
+            return color;
+
+        if (brightness == 0)
+            return CRGB::Black;
+
+        /* brightness + 1 & lit channels stay lit, as in ColorFromPalette() */
+        brightness++;
+
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            if (color.raw[i] == 0)
+                continue;
+
+            color.raw[i] = scale8(color.raw[i], brightness);
+#if !(FASTLED_SCALE8_FIXED == 1)
+            color.raw[i]++;
+#endif
+        }
+
+        return color;
+    }
+
+    /**
+     * @brief Returns the pixels changed by the last update() & clears them
+     * @note If update() returned 1 without marking a range with led_array.mark_dirty(),
+     *       the whole led_array is considered changed
+     * 
+     * @param changed return value of update()
+     * @param start first changed pixel on the led strip
+     * @param end one past the last changed pixel on the led strip
+     * @return true when pixels changed
+     * @return false no change
+     */
+    bool take_dirty_range(bool changed, CRGB *&start, CRGB *&end)
+    {
+        if (changed && !led_array.is_dirty())
+            led_array.mark_dirty();
+
+        if (!led_array.is_dirty())
+            return 0;
+
+        start = led_array.get_dirty_start();
+        end = led_array.get_dirty_end();
+        led_array.clear_dirty();
+
+        /* Layer buffer's range to the layer's position on the strip */
+        if (is_layer())
+        {
+            start = layer_position + (start - led_array.get_start());
+            end = layer_position + (end - led_array.get_start());
+        }
+
+        return 1;
+    }
+
+    /**
+     * @brief Sets how often the led manager calls update()
+     * 
+     * @param period update every n frames. 1 updates on every frame
+     * @param phase frame offset. Spreads effects with the same period over different frames
+     */
+    void set_update_interval(uint8_t period, uint8_t phase = 0)
+    {
+        if (period == 0)
+            period = 1;
+
+        update_period = period;
+        update_countdown = phase % period;
+    }
+
+    /**
+     * @brief Marks the effect as the first one to slow down when frames overrun.
+     *      See led_manager::set_quality_governor()
+     * 
+     * @param enable 
+     */
+    void set_low_priority(bool enable) {low_priority = enable;}
+
+    bool is_low_priority() {return low_priority;}
+
+    /**
+     * @brief Halves the update rate on top of set_update_interval(). Set by the quality governor
+     * 
+     * @param enable 
+     */
+    void set_throttle(bool enable) {throttle_shift = enable;}
+
+    /**
+     * @brief Returns the effect's fft so the quality governor can shrink its window.
+     * @note Override in effects which own an FFT object
+     * 
+     * @return FFT* nullptr when the effect has none
+     */
+    virtual FFT *get_fft() {return nullptr;}
+
+    /**
+     * @brief Limits how long update() runs per call. 
+     *      Coroutine style effects yield with EFFECT_YIELD_IF_BUDGET_SPENT()
+     *      once the budget is used, and continue on the next frame.
+     * 
+     * @param budget_us time in us. 0 disables the limit
+     */
+    void set_work_budget(uint16_t budget_us) {work_budget_us = budget_us;}
+
+    /**
+     * @brief Returns 1 when update() has run longer than its work budget
+     * 
+     */
+    bool budget_spent()
+    {
+        if (!work_budget_us)
+            return 0;
+
+        return (uint16_t) ((uint16_t) micros() - update_start_time) >= work_budget_us;
+    }
+
+    /**
+     * @brief Returns 1 when a coroutine style update() has yielded and 
+     *      waits to be continued
+     * 
+     */
+    bool is_suspended() {return coroutine_line != 0;}
+
+    /**
+     * @brief Advances the effect's frame counter & starts the work budget timer.
+     * @note Called by the led strip once per frame.
+     *       Suspended effects are continued on every frame, 
+     *       the update interval restarts once they finish.
+     * 
+     * @return true when update() is due on this frame
+     * @return false skip this frame
+     */
+    bool frame_tick()
+    {
+        uint16_t period = 0;
+
+        if (is_suspended())
+        {
+            update_start_time = micros();
+            return 1;
+        }
+
+        if (update_countdown)
+        {
+            update_countdown--;
+            return 0;
+        }
+
+        period = update_period << throttle_shift;
+        update_countdown = (period > 255 ? 255 : period) - 1;
+        update_start_time = micros();
+        return 1;
+    }
+
+    /**
+     * @brief Returns time in us until the effect next needs update().
+     *      Used by led_manager::idle() to sleep between frames.
+     * @note Override in effects which change only now and then. 
+     *       Default 0 needs update() on every frame
+     * 
+     * @return uint32_t 
+     */
+    virtual uint32_t get_sleep_time() {return 0;}
+
+    /**
+     * @brief Subscribes the effect to the event. See on_event()
+     * 
+     * @param type 
+     */
+    void subscribe(event_type type) {event_mask |= 1 << type;}
 
-    void set_color_palette(const TProgmemPalette16 &palette) {color_palette = palette;}
+    void unsubscribe(event_type type) {event_mask &= ~(1 << type);}
+
+    bool is_subscribed(event_type type) {return event_mask & (1 << type);}
+
+    /**
+     * @brief Stops polling update() on every frame. The effect runs only 
+     *      from on_event() for the events it's subscribed to
+     * @note Effects which animate between events have to stay polled
+     * 
+     * @param enable 
+     */
+    void set_event_driven(bool enable) {event_driven = enable;}
+
+    bool is_event_driven() {return event_driven;}
+
+    /**
+     * @brief Called by led_manager::update() for each subscribed event.
+     *      Events are dispatched on every update() call, not only on the effect's frames
+     * @note Same rules as update(). Return 1 if any led value changed
+     * 
+     * @param e 
+     * @return true When led value changed
+     * @return false when no change happened
+     */
+    virtual bool on_event(const event &e) {return 0;}
 
     /**
      * @brief 
      * @note function wich should be implemented in the inherited class the following way.
      *       updates the led strip's values. 
      *       Returns 1 if any led value changed. Othervise 0
+     *       Changed range can be reported with led_array.mark_dirty(first, end)
+     *       so that only the changed part of the strip is pushed to the leds
      *       update shouldn't call FastLED.show() or any other function that updates the led strips
+     *       Time & audio features are read from the frame context instead of millis() / micros()
      * 
+     * @param context frame's time, frame number & audio features
      * @return true When led value changed
      * @return false when no change happened
      */
-    virtual bool update() = 0;
+    virtual bool update(const frame_context &context) = 0;
 
     audioMode() {}
     virtual ~audioMode() = default;
@@ -28,6 +28,11 @@ colorBass::colorBass()
 {
 }
 
+colorBass::colorBass(audio_source &source)
+    : fft_obj(source, 64, 800, fixed_8)
+{
+}
+
 /**
  * @brief Changes leds color based on the frequency of bass. Led brightness is controlled by the magnitude
  *        of the input signal.
@@ -35,10 +40,28 @@ colorBass::colorBass()
  *
  * @returns bool: 1 If value has changed.
  */
-bool colorBass::update()
+bool colorBass::update(const frame_context &context)
 {
     uint16_t freq = 0;
-    uint16_t brightness = analogRead(0);
+    uint16_t brightness = 0;
+    uint32_t time_delta = 0;
+
+    /* First update has no previous frame. Effects can be added long after the first frame */
+    if (m_has_updated)
+        time_delta = context.time_ms - m_last_update_ms;
+
+    m_last_update_ms = context.time_ms;
+    m_has_updated = 1;
+
+    /* Clamp quietly. The filters warn & hold their value from a second up */
+    if (time_delta > 999)
+        time_delta = 999;
+
+    /* Envelope steps by this effect's own update interval. Sub-ms frames leave the samples for the next step */
+    if (time_delta)
+        fft_obj.update_envelope(time_delta);
+
+    brightness = fft_obj.get_peak_envelope();
 
     if (_update)
     {
@@ -54,15 +77,15 @@ bool colorBass::update()
         DEBUG(F("Freq: "), freq);
     }
 
-    // 414 is the input calzero
-    brightness = constrain(brightness, 414, 800);
-    brightness = map(brightness, 414, 550, 0, 255);
+    /* Envelope is relative to the input's dc level (previously calzero of 414) */
+    brightness = constrain(brightness, 0, 136);
+    brightness = map(brightness, 0, 136, 0, 255);
 
     /* if no change in brightness */
     if (brightness == _lastBrightness)
     {
         /* check if fade is complete */
-        if (!fade(freq, (uint8_t) brightness))
+        if (!fade(freq, (uint8_t) brightness, time_delta))
         {
             _update = 0;
             return _update;
@@ -74,7 +97,7 @@ bool colorBass::update()
     /* Brightness changed */
     _lastBrightness = brightness;
 
-    _update = fade(freq, brightness);
+    _update = fade(freq, brightness, time_delta);
     return _update;
 }
 
@@ -83,12 +106,16 @@ bool colorBass::update()
  *
  * @param hue
  * @param brightness
+ * @param time_delta ms since the previous call
  */
-uint8_t colorBass::fade(uint16_t hue, uint16_t brightness)
+uint8_t colorBass::fade(uint16_t hue, uint16_t brightness, uint16_t time_delta)
 {
+    if (hue > 0x7FFF)
+        hue = 0x7FFF;
+
     /* Smoothen the input values */
-    float val = bright1.calc((float)brightness);
-    float colorVal = color_smooth.calc((float)hue);
+    int16_t val = bright1.calc(brightness, time_delta);
+    int16_t colorVal = color_smooth.calc(hue, time_delta);
 
     /* Limit color value */
     if (colorVal > 255)
@@ -98,10 +125,7 @@ uint8_t colorBass::fade(uint16_t hue, uint16_t brightness)
 
     /* Fill led_array with the smoothed values */
     fill_solid(&led_array[0], led_array.size(),
-           ColorFromPalette(color_palette,
-                        (uint8_t) colorVal,
-                        (uint8_t) val,
-                        LINEARBLEND));
+           palette_color((uint8_t) colorVal, (uint8_t) val));
 
     /* Check if no rgb values have changed */
     if (led_array[0].r == m_last_r && led_array[0].g == m_last_g && led_array[0].b == m_last_b)
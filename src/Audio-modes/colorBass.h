@@ -41,11 +41,15 @@ class colorBass : public audioMode // Simple bass effect
     FFT fft_obj;
 
 private:
-    inline uint8_t fade(uint16_t freq, uint16_t brightness);
+    inline uint8_t fade(uint16_t freq, uint16_t brightness, uint16_t time_delta);
     inline void logLastValue(uint8_t hue, uint8_t saturation, uint8_t value);
 
-    EWMAtest bright1 = EWMAtest(0.01F);
-    EWMAtest color_smooth = EWMAtest(0.01F);
+    exp_smoother bright1 = exp_smoother(0.01F);
+    exp_smoother color_smooth = exp_smoother(0.01F);
+
+    /* Frame time of the previous update(). Filters step by the time between updates */
+    uint32_t m_last_update_ms = 0;
+    bool m_has_updated = 0;
 
     /* Last Values */
     uint8_t m_last_r;
@@ -54,15 +58,26 @@ private:
 
 public:
     colorBass();
+
+    /**
+     * @brief Construct a new colorBass object which analyses the audio source
+     *      instead of the adc. e.g. synthetic_audio_source for benchmarks
+     *
+     * @param source
+     */
+    colorBass(audio_source &source);
     ~colorBass() = default;
 
+    FFT *get_fft() override {return &fft_obj;}
+
     /**
      * @brief updates the leds
      * 
+     * @param context
      * @return true
      * @return false 
      */
-    virtual bool update();
+    virtual bool update(const frame_context &context);
 };
 
 #endif
\ No newline at end of file
@@ -24,11 +24,54 @@
 
 #include "SubEffects.h"
 
+/**
+ * @brief Dispatches the queued events & runs a frame if one is due. 
+ *      Updates the due effects & pushes the changes to the leds
+ * 
+ * @return true if any led changed
+ * @return false no changes or frame wasn't due yet
+ */
 bool led_manager::update()
 {
     sl_list::node<ledStrip> *led_strip_iter = led_strip_list.head();
+    uint32_t now = micros();
     bool update_state = 0;
-    
+
+    /* Push the output held back for the sampler before effects restart sampling */
+    if (output_pending)
+        push_output();
+
+    /* Leave rest of the frame idle. Only the events are handled */
+    if (!frame_due(now))
+    {
+        if (!dispatch_events())
+            return 0;
+
+        push_output();
+        return 1;
+    }
+
+    frame_number++;
+    PROFILE_START(frame_start);
+
+    /* Frame's clock. Effects read the time from the context */
+    frame_context context = {now, 0, 0, frame_number, audio};
+
+    if (frame_number > 1)
+    {
+        context.dt_us = now - frame_time_us;
+        frame_time_remainder_us += context.dt_us % 1000;
+        frame_time_ms += context.dt_us / 1000 + frame_time_remainder_us / 1000;
+        frame_time_remainder_us %= 1000;
+    }
+
+    frame_time_us = now;
+    context.time_ms = frame_time_ms;
+
+    update_audio_features(context.dt_us);
+
+    update_state = dispatch_events();
+
     /* iterate over all ledstrips */
     while (led_strip_iter != nullptr)
     {
@@ -40,18 +83,663 @@ bool led_manager::update()
         }
 
         /* Update effects on the led strip */
-        if (led_strip_iter->data->update())
+        if (led_strip_iter->data->update(context))
             update_state = 1;
 
         led_strip_iter = led_strip_list.next(led_strip_iter);
     }
 
+    /* Skip output when nothing changed */
     if (update_state)
-        FastLED.show();
+        push_output();
+
+    if (governor_enabled)
+        govern(micros() - now);
 
+    PROFILE_END(profiler.frame, frame_start);
     return update_state;
 }
 
+/**
+ * @brief Checks whether the next frame is due.
+ *      Frame clock ticks are used when it runs, micros() otherwise
+ * 
+ * @param now micros() of this update() call
+ * @return true run the frame
+ * @return false 
+ */
+bool led_manager::frame_due(uint32_t now)
+{
+    uint8_t ticks = 0;
+
+    if (frame_clock_active())
+    {
+        cli();
+        ticks = frame_clock.ticks;
+        frame_clock.ticks = 0;
+        sei();
+
+        /* Missed ticks are dropped instead of running a burst of frames */
+        if (!ticks)
+            return 0;
+
+        last_frame_time = now;
+        return 1;
+    }
+
+    if (!frame_period_us)
+        return 1;
+
+    if (now - last_frame_time < frame_period_us)
+        return 0;
+
+    last_frame_time += frame_period_us;
+
+    /* Fell behind by over a frame. Resync instead of running a burst of frames */
+    if (now - last_frame_time >= frame_period_us)
+        last_frame_time = now;
+
+    return 1;
+}
+
+/**
+ * @brief Analyses the audio input's latest window for the frame context
+ * 
+ * @param time_delta_us time since the previous frame
+ */
+void led_manager::update_audio_features(uint32_t time_delta_us)
+{
+    uint16_t frequency = 0;
+
+    if (audio_input == nullptr)
+        return;
+
+    /* Envelope steps over the frames without new samples too */
+    audio_time_delta_us += time_delta_us;
+
+    /* Sub-ms remainder carries over to the next step */
+    if (audio_time_delta_us >= 1000 && audio_input->update_envelope(audio_time_delta_us / 1000))
+    {
+        audio_time_delta_us %= 1000;
+        audio.peak = audio_input->get_peak_envelope();
+        audio.rms = audio_input->get_rms_envelope();
+    }
+
+    frequency = audio_input->calculate();
+
+    if (frequency)
+    {
+        audio.dominant_frequency = frequency;
+        audio.window_count++;
+    }
+}
+
+/**
+ * @brief Sets the FFT analysed once per frame for frame_context::audio.
+ *      Effects can share one analysis instead of each owning an FFT
+ * 
+ * @param fft nullptr to disable
+ */
+void led_manager::set_audio_input(FFT *fft)
+{
+    audio_input = fft;
+    audio = audio_features();
+    audio_time_delta_us = 0;
+}
+
+/**
+ * @brief Steps the quality level down after consecutive overrunning frames 
+ *      and back up after consecutive frames with headroom. See config.h
+ * 
+ * @param frame_time_us time the frame took
+ */
+void led_manager::govern(uint32_t frame_time_us)
+{
+    if (!frame_period_us)
+        return;
+
+    if (frame_time_us > frame_period_us)
+    {
+        headroom_frames = 0;
+
+        if (++overrun_frames < GOVERNOR_OVERRUN_FRAMES)
+            return;
+
+        overrun_frames = 0;
+
+        if (quality < quality_lowest)
+            set_quality_level((quality_level)(quality + 1));
+
+        return;
+    }
+
+    overrun_frames = 0;
+
+    if (frame_time_us * 100 > frame_period_us * GOVERNOR_HEADROOM_PERCENT)
+    {
+        headroom_frames = 0;
+        return;
+    }
+
+    if (++headroom_frames < GOVERNOR_RESTORE_FRAMES)
+        return;
+
+    headroom_frames = 0;
+
+    if (quality > quality_full)
+        set_quality_level((quality_level)(quality - 1));
+}
+
+/**
+ * @brief Passes the queued events to the subscribed effects
+ * 
+ * @return true if any led changed
+ * @return false 
+ */
+bool led_manager::dispatch_events()
+{
+    sl_list::node<ledStrip> *led_strip_iter = nullptr;
+    bool changed = 0;
+    event e;
+
+    while (!event_bus.take(e))
+    {
+        led_strip_iter = led_strip_list.head();
+
+        while (led_strip_iter != nullptr)
+        {
+            if (led_strip_iter->data != nullptr && led_strip_iter->data->dispatch_event(e))
+                changed = 1;
+
+            led_strip_iter = led_strip_list.next(led_strip_iter);
+        }
+    }
+
+    #ifdef DEBUG_CHECKS
+    if (event_bus.take_dropped())
+        WARN(F("dispatch_events: event queue was full. See EVENT_QUEUE_SIZE"));
+    #endif
+
+    return changed;
+}
+
+/**
+ * @brief Puts the mcu to idle sleep until the next frame, 
+ *      the earliest effect wake up time, a completed sampling window or a queued event.
+ *      Call in loop() after update().
+ * @note Idle mode keeps timers & the sampling isr running. 
+ *       Every interrupt wakes the mcu. Sleep is continued until one of the above is due.
+ *       Doesn't sleep if no frame rate is set and an effect needs update() on every frame.
+ * 
+ */
+void led_manager::idle()
+{
+    sl_list::node<ledStrip> *led_strip_iter = led_strip_list.head();
+    sl_list::dl_node<audioMode> *effect_node = nullptr;
+    uint32_t sleep_time = 0xFFFFFFFF;
+    uint32_t effect_sleep_time = 0;
+    uint32_t start = micros();
+
+    /* Earliest effect wake up */
+    while (led_strip_iter != nullptr)
+    {
+        if (led_strip_iter->data != nullptr)
+        {
+            effect_node = led_strip_iter->data->effect_list.head();
+
+            while (effect_node != nullptr)
+            {
+                /* Event driven effects are woken by their events */
+                if (!effect_node->data->is_event_driven())
+                {
+                    effect_sleep_time = effect_node->data->get_sleep_time();
+
+                    if (effect_sleep_time < sleep_time)
+                        sleep_time = effect_sleep_time;
+                }
+
+                effect_node = led_strip_iter->data->effect_list.next(effect_node);
+            }
+        }
+
+        led_strip_iter = led_strip_list.next(led_strip_iter);
+    }
+
+    /* Frame clock tick wakes the mcu. Effects run only on frames */
+    if (frame_clock_active())
+    {
+        if (frame_clock.ticks)
+            return;
+
+        sleep_time = 0xFFFFFFFE;
+    }
+    /* Effects run only on frames. Sleep at least until the next one */
+    else if (frame_period_us)
+    {
+        effect_sleep_time = last_frame_time + frame_period_us - start;
+
+        if ((int32_t) effect_sleep_time <= 0)
+            return;
+
+        if (sleep_time == 0xFFFFFFFF || effect_sleep_time > sleep_time)
+            sleep_time = effect_sleep_time;
+    }
+
+    if (!sleep_time || sleep_time == 0xFFFFFFFF)
+        return;
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+
+    while (micros() - start < sleep_time)
+    {
+        cli();
+
+        if (fft_window_complete || frame_clock.ticks || !event_bus.is_empty())
+        {
+            fft_window_complete = 0;
+            sei();
+            break;
+        }
+
+        sleep_enable();
+
+        /* sei() takes effect after the next instruction. Wake up interrupt can't be missed */
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    }
+}
+
+/**
+ * @brief Pushes the changes to the leds, or holds them back 
+ *      while the sampler is filling a window. See set_sampler_sync()
+ * @note led output blocks interrupts for the duration of the strip.
+ *       A block shorter than a sample period only delays the pending sample.
+ *       Windows filling during a longer block have lost samples
+ * 
+ */
+void led_manager::push_output()
+{
+    uint32_t frequency = timer1::GetFrequency();
+    uint8_t filling = fft_window_filling;
+    uint32_t blocked_us = 0;
+
+    if (sampler_sync && (filling & fft_primary_window) && frequency)
+    {
+        if (!output_pending)
+        {
+            output_pending = 1;
+            output_pending_since = millis();
+            return;
+        }
+
+        /* Wait at most the length of one window */
+        if (millis() - output_pending_since <= (uint32_t) fft_window_samples * 1000 / frequency)
+            return;
+    }
+
+    output_pending = 0;
+    filling = fft_window_filling;
+    blocked_us = show_strips();
+
+    if (!filling || !frequency || blocked_us * frequency <= 1000000UL)
+        return;
+
+    corrupted_windows++;
+
+    if (!discard_corrupted_windows)
+        return;
+
+    cli();
+    fft_window_corrupted |= filling;
+    sei();
+}
+
+/**
+ * @brief Returns the number of samples taken over half a sample period late
+ * @note Counted only when CONF_SAMPLER_STATS is 1
+ * 
+ * @return uint16_t 
+ */
+uint16_t led_manager::get_late_samples()
+{
+    uint16_t late_samples;
+
+    cli();
+    late_samples = fft_late_samples;
+    sei();
+    return late_samples;
+}
+
+/**
+ * @brief Resets the late sample & corrupted window counters
+ * 
+ */
+void led_manager::reset_sampler_stats()
+{
+    cli();
+    fft_late_samples = 0;
+    sei();
+    corrupted_windows = 0;
+}
+
+/**
+ * @brief Pushes the changed led strips to the leds
+ * 
+ * @return uint16_t longest time in us interrupts were blocked by a single push
+ * @note Measured with micros(), which misses the timer0 overflows after the first
+ *       while interrupts are blocked. Pushes over ~2 ms are measured short
+ */
+uint16_t led_manager::show_strips()
+{
+    sl_list::node<ledStrip> *led_strip_iter = led_strip_list.head();
+    uint16_t longest_push_us = 0;
+    uint16_t start = 0;
+
+    /* Changed strip without own controller. FastLED.show() pushes every strip */
+    while (led_strip_iter != nullptr)
+    {
+        if (led_strip_iter->data != nullptr &&
+            led_strip_iter->data->get_controller() == nullptr &&
+            led_strip_iter->data->is_dirty())
+        {
+            /* FastLED.show() pushes the strips with own controller too. Their output buffers have to be current */
+            for (led_strip_iter = led_strip_list.head(); led_strip_iter != nullptr; led_strip_iter = led_strip_list.next(led_strip_iter))
+            {
+                if (led_strip_iter->data != nullptr && led_strip_iter->data->is_dirty())
+                    led_strip_iter->data->update_output();
+            }
+
+            PROFILE_START(show_start);
+            start = micros();
+            FastLED.show();
+            longest_push_us = (uint16_t) micros() - start;
+            PROFILE_END(profiler.show, show_start);
+
+            clear_dirty();
+            return longest_push_us;
+        }
+
+        led_strip_iter = led_strip_list.next(led_strip_iter);
+    }
+
+    /* 
+     * Push only the strips with changes which are due for refresh.
+     * Interrupts are disabled only for the duration of one strip at a time
+     */
+    led_strip_iter = led_strip_list.head();
+    while (led_strip_iter != nullptr)
+    {
+        if (led_strip_iter->data != nullptr && 
+            !led_strip_iter->data->show() &&
+            led_strip_iter->data->get_last_push_us() > longest_push_us)
+        {
+            longest_push_us = led_strip_iter->data->get_last_push_us();
+        }
+
+        led_strip_iter = led_strip_list.next(led_strip_iter);
+    }
+
+    return longest_push_us;
+}
+
+/**
+ * @brief Prints the profiler counters over serial
+ * @note Does nothing when CONF_ENABLE_PROFILER is 0
+ * 
+ * @param reset 1 to reset the counters after printing
+ */
+void led_manager::print_profile(bool reset)
+{
+#if CONF_ENABLE_PROFILER == 1
+    sl_list::node<ledStrip> *led_strip_iter = led_strip_list.head();
+    sl_list::dl_node<audioMode> *effect_node = nullptr;
+    uint8_t strip_index = 0;
+    uint8_t effect_index = 0;
+
+    profiler.frame.print(F("frame"));
+    profiler.show.print(F("show"));
+    profiler.fft.print(F("fft"));
+    profiler.post_process.print(F("post_process"));
+
+    while (led_strip_iter != nullptr)
+    {
+        if (led_strip_iter->data == nullptr)
+        {
+            led_strip_iter = led_strip_list.next(led_strip_iter);
+            continue;
+        }
+
+        effect_node = led_strip_iter->data->effect_list.head();
+        effect_index = 0;
+
+        while (effect_node != nullptr)
+        {
+            if (effect_node->data != nullptr)
+            {
+                DEBUG_OUT_NC(F("strip "));
+                DEBUG_OUT_NC(strip_index);
+                DEBUG_OUT_NC(F(" effect "));
+                DEBUG_OUT_NC(effect_index);
+                DEBUG_OUT_NC(F(": "));
+                effect_node->data->profile.print(F("update"));
+
+                if (reset)
+                    effect_node->data->profile.reset();
+            }
+
+            effect_index++;
+            effect_node = led_strip_iter->data->effect_list.next(effect_node);
+        }
+
+        strip_index++;
+        led_strip_iter = led_strip_list.next(led_strip_iter);
+    }
+
+    if (reset)
+    {
+        profiler.frame.reset();
+        profiler.show.reset();
+        profiler.fft.reset();
+        profiler.post_process.reset();
+    }
+#endif
+}
+
+/**
+ * @brief Clears the changed range of all led strips
+ * 
+ */
+void led_manager::clear_dirty()
+{
+    sl_list::node<ledStrip> *led_strip_iter = led_strip_list.head();
+
+    while (led_strip_iter != nullptr)
+    {
+        if (led_strip_iter->data != nullptr)
+            led_strip_iter->data->clear_dirty();
+
+        led_strip_iter = led_strip_list.next(led_strip_iter);
+    }
+}
+
+
+/**
+ * @brief Locks the updates to a target frame rate.
+ *      Effects are updated only on their frames. See audioMode::set_update_interval()
+ * @note set_frame_clock() overrides this while timer1 is running
+ * 
+ * @param fps frames per second. 0 runs a frame on every update() call
+ */
+void led_manager::set_frame_rate(uint16_t fps)
+{
+    if (fps == 0)
+    {
+        frame_period_us = 0;
+        return;
+    }
+
+    frame_period_us = 1000000UL / fps;
+    last_frame_time = micros();
+}
+
+/**
+ * @brief Runs the frames on timer1, the clock of the adc sampling isr. 
+ *      Frames are counted in sampling periods on the timer1 compare A interrupt, 
+ *      so frames & sampling windows stay in lockstep without millis() jitter.
+ *      e.g. fps of sampling frequency / sample size runs a frame for every window.
+ * @note Requires CONF_ENABLE_FRAME_CLOCK & a running FFT sampling the adc. 
+ *       Frames fall back to micros() if timer1 is stopped. 0 turns the clock off.
+ *       The compare A interrupt runs on every sampling period to count down the divider
+ * 
+ * @param fps frames per second. Rounded to a whole number of sampling periods
+ * @return true timer1 isn't running, its compare A vector is in use or the clock is disabled
+ * @return false 
+ */
+bool led_manager::set_frame_clock(uint16_t fps)
+{
+#if CONF_ENABLE_FRAME_CLOCK == 1
+    uint32_t frequency = timer1::GetFrequency();
+    uint32_t divider = 0;
+
+    if (fps == 0)
+    {
+        cli();
+        TIMSK1 &= ~(1 << OCIE1A);
+
+        if (get_isr_vector(TIMER1_COMPA_) == __vector_timer1_compa_frame_clock)
+        {
+            unbind_isr(TIMER1_COMPA_);
+            unbind_isr_data_ptr(TIMER1_COMPA_ptr);
+        }
+
+        frame_clock.divider = 0;
+        sei();
+        return 0;
+    }
+
+    if (frequency == 0)
+    {
+        ERROR(F("set_frame_clock: timer1 isn't running. Start the adc sampling FFT first"));
+        return 1;
+    }
+
+    if (get_isr_vector(TIMER1_COMPA_) != nullptr &&
+        get_isr_vector(TIMER1_COMPA_) != __vector_timer1_compa_frame_clock)
+    {
+        ERROR(F("set_frame_clock: timer1 compa vector is already in use"));
+        return 1;
+    }
+
+    divider = frequency / fps;
+
+    if (divider == 0)
+        divider = 1;
+    else if (divider > 0xFFFF)
+        divider = 0xFFFF;
+
+    cli();
+    frame_clock.divider = divider;
+    frame_clock.countdown = divider;
+    frame_clock.ticks = 0;
+    bind_isr_data_ptr(TIMER1_COMPA_ptr, &frame_clock);
+    bind_isr(TIMER1_COMPA_, __vector_timer1_compa_frame_clock);
+    TIFR1 = (1 << OCF1A);
+    TIMSK1 |= (1 << OCIE1A);
+    sei();
+
+    /* Fallback timing & idle() use the achieved frame period */
+    frame_period_us = 1000000UL / (frequency / divider);
+    last_frame_time = micros();
+
+    INFO(F("set_frame_clock: fps: "), frequency / divider);
+    return 0;
+#else
+    if (fps == 0)
+        return 0;
+
+    ERROR(F("set_frame_clock: set CONF_ENABLE_FRAME_CLOCK to 1 in config.h"));
+    return 1;
+#endif
+}
+
+#if CONF_ENABLE_FRAME_CLOCK == 1
+__attribute__((signal)) void __vector_timer1_compa_frame_clock()
+{
+    frame_clock_interrupt *data = (struct frame_clock_interrupt *) get_isr_data_ptr(TIMER1_COMPA_ptr);
+
+    if (--data->countdown)
+        return;
+
+    data->countdown = data->divider;
+
+    if (data->ticks != 0xFF)
+        data->ticks++;
+}
+#endif
+
+/**
+ * @brief Lowers the quality when frames overrun the frame period & restores it once 
+ *      there's headroom again. Levels in order: low priority effects' update rate,
+ *      fft window size & post processing. See quality_level
+ * @note Requires set_frame_rate() or set_frame_clock(). 
+ *       Frame time doesn't include idle(). micros() misses time during long led output,
+ *       so frames with output are measured a bit short.
+ *       Effects added later get the current level on the next level change.
+ * 
+ * @param enable 0 restores the full quality
+ */
+void led_manager::set_quality_governor(bool enable)
+{
+    governor_enabled = enable;
+    overrun_frames = 0;
+    headroom_frames = 0;
+
+    if (!enable)
+        set_quality_level(quality_full);
+}
+
+/**
+ * @brief Applies the quality level to every led strip & effect
+ * 
+ * @param level 
+ */
+void led_manager::set_quality_level(quality_level level)
+{
+    sl_list::node<ledStrip> *led_strip_iter = led_strip_list.head();
+    sl_list::dl_node<audioMode> *effect_node = nullptr;
+    FFT *effect_fft = nullptr;
+
+    while (led_strip_iter != nullptr)
+    {
+        if (led_strip_iter->data == nullptr)
+        {
+            led_strip_iter = led_strip_list.next(led_strip_iter);
+            continue;
+        }
+
+        led_strip_iter->data->set_reduced_quality(level >= quality_reduced_post_processing);
+        effect_node = led_strip_iter->data->effect_list.head();
+
+        while (effect_node != nullptr)
+        {
+            effect_node->data->set_throttle(effect_node->data->is_low_priority() && level >= quality_throttled_effects);
+            effect_fft = effect_node->data->get_fft();
+
+            if (effect_fft != nullptr && effect_fft->set_quality_shift(level >= quality_reduced_fft))
+                WARN(F("set_quality_level: fft window size can't be changed"));
+
+            effect_node = led_strip_iter->data->effect_list.next(effect_node);
+        }
+
+        led_strip_iter = led_strip_list.next(led_strip_iter);
+    }
+
+    if (level != quality)
+        INFO(F("Quality level: "), level);
+
+    quality = level;
+}
 
 bool led_manager::_add_ledstrip(
         sl_list::node<ledStrip> &ledstrip_node,
@@ -75,6 +763,9 @@ bool led_manager::_add_ledstrip(
 
 /**
  * @brief Add led strip to led manager
+ * @note The strip is shown with FastLED.show(), which keeps FastLED's power limit, 
+ *       dithering & refresh rate. Use the CLEDController overload to show it on its own.
+ *       Post processing (ledStrip::enable_post_processing()) needs the CLEDController overload
  * 
  * @param led_strip 
  * @param pixel_array
@@ -93,6 +784,29 @@ bool led_manager::add_led_strip(
             array_size);
 }
 
+/**
+ * @brief Add led strip driven by its own FastLED controller.
+ *      Only the strips with changed pixels are pushed to the leds.
+ * @note The strip skips FastLED.show() & with it FastLED's power limit, 
+ *       dithering & refresh rate. See ledStrip::set_current_limit() & set_refresh_rate()
+ * 
+ * @param led_strip 
+ * @param controller Controller returned by FastLED.addLeds()
+ * @return true 
+ * @return false 
+ */
+bool led_manager::add_led_strip(
+        ledStrip &led_strip,
+        CLEDController &controller)
+{
+    led_strip.set_controller(&controller);
+
+    return _add_ledstrip(
+            led_strip.ledStrip_node,
+            controller.leds(),
+            controller.size());
+}
+
 /**
  * @brief Add audio effect to led strip with defined pixel range
  * 
@@ -130,6 +844,34 @@ bool led_manager::add_effect(
     return led_strip.add_effect(audio_effect);
 }
 
+/**
+ * @brief Add audio effect as a blended layer on top of the led strip's other effects.
+ *      See ledStrip::add_layer()
+ * 
+ * @param led_strip 
+ * @param audio_effect 
+ * @param pixel_start layer's first pixel on the strip
+ * @param pixel_end one past layer's last pixel on the strip
+ * @param layer_buffer buffer the effect renders to. (pixel_end - pixel_start) pixels
+ * @param mode blend mode
+ * @param z_order higher is on top
+ * @param alpha used by blend_alpha
+ * @return true 
+ * @return false 
+ */
+bool led_manager::add_layer(
+        ledStrip &led_strip,
+        audioMode &audio_effect,
+        CRGB *pixel_start,
+        CRGB *pixel_end,
+        CRGB *layer_buffer,
+        blend_mode mode,
+        uint8_t z_order,
+        uint8_t alpha)
+{
+    return led_strip.add_layer(audio_effect, pixel_start, pixel_end, layer_buffer, mode, z_order, alpha);
+}
+
 /**
  * @brief Removes the effect from led strip
  * 
@@ -146,26 +888,40 @@ bool led_manager::remove_effect(
 }
 
 /**
- * @brief Searches all led strips until effect is found and removes it
- * @note doesn't remove from all ledstrips since effect shouldn't  be able to be in multiple ledstrips
+ * @brief Cross-fades from outgoing effect to incoming. See ledStrip::transition()
+ * 
+ * @param led_strip 
+ * @param outgoing effect on the strip
+ * @param incoming effect which takes over outgoing's pixels
+ * @param buffer outgoing's size in pixels
+ * @param duration_ms 
+ * @return true 
+ * @return false 
+ */
+bool led_manager::transition(
+        ledStrip &led_strip,
+        audioMode &outgoing,
+        audioMode &incoming,
+        CRGB *buffer,
+        uint16_t duration_ms)
+{
+    return led_strip.transition(outgoing, incoming, buffer, duration_ms);
+}
+
+/**
+ * @brief Removes effect from the led strip it's on
+ * @note Effect can't be in multiple ledstrips
  * @param audio_effect 
  * @return true 
  * @return false 
  */
 bool led_manager::remove_effect(audioMode &audio_effect)
 {
-    sl_list::node<ledStrip> *led_strip_iter = led_strip_list.head();
-
-    while(led_strip_iter != nullptr)
+    if (audio_effect.get_led_strip() == nullptr)
     {
-        if (led_strip_iter->data == nullptr) break;
-
-        if (!led_strip_iter->data->remove_effect(audio_effect))
-            return 0;
-
-        led_strip_iter = led_strip_list.next(led_strip_iter);
+        ERROR(F("remove_effect: effect isn't on any led strip"));
+        return 1;
     }
 
-    /* Not found */
-    return 1;
+    return audio_effect.get_led_strip()->remove_effect(audio_effect);
 }
\ No newline at end of file
@@ -32,18 +32,94 @@
 #include <Arduino.h>
 #include <inttypes.h>
 #include <FastLED.h>
+#include <avr/sleep.h>
 #include "config.h"
 #include "utils/debug.h"
+#include "utils/profiler.h"
 #include "utils/ledStrip.h"
+#include "utils/arch/avr/atmega328p/timer1.h"
 #include "utils/data_types/virtual_led_array.h"
+#include "utils/FFT/FFT.h"
+#include "utils/FFT/spectrogram_history.h"
 #include "Audio-modes/audioModes.h"
 
 
+/**
+ * @brief Data of the frame clock isr bound to timer1 compare A.
+ *      Counts sampling periods down to the next frame
+ */
+struct frame_clock_interrupt
+{
+    volatile uint16_t divider = 0;
+    volatile uint16_t countdown = 0;
+    volatile uint8_t ticks = 0;         // frames due. Saturates at 255
+};
+
+#if CONF_ENABLE_FRAME_CLOCK == 1
+extern void __vector_timer1_compa_frame_clock();
+#endif
+
+/**
+ * @brief Quality levels of led_manager's governor. Each level keeps the reductions of the previous ones
+ * 
+ */
+typedef enum : uint8_t
+{
+    quality_full = 0,
+    quality_throttled_effects,          // low priority effects update at half rate
+    quality_reduced_fft,                // fft windows halved
+    quality_reduced_post_processing,    // gamma correction suspended
+    quality_lowest = quality_reduced_post_processing
+} quality_level;
+
 class led_manager
 {
 private:
     sl_list::handler<ledStrip> led_strip_list;
+
+    /* Frame scheduling */
+    uint32_t frame_period_us = 0;
+    uint32_t last_frame_time = 0;
+    uint32_t frame_number = 0;
+    frame_clock_interrupt frame_clock;
+
+    /* Quality governor */
+    bool governor_enabled = 0;
+    quality_level quality = quality_full;
+    uint8_t overrun_frames = 0;
+    uint8_t headroom_frames = 0;
+
+    void govern(uint32_t frame_time_us);
+
+    /* Led output held back until the sampling window is full */
+    bool sampler_sync = 0;
+    bool output_pending = 0;
+    uint32_t output_pending_since = 0;
+    uint16_t corrupted_windows = 0;
+    bool discard_corrupted_windows = 0;
     
+    void clear_dirty();
+
+    void push_output();
+
+    bool frame_due(uint32_t now);
+
+    /* Frame clock & audio features passed to the effects */
+    uint32_t frame_time_us = 0;
+    uint32_t frame_time_ms = 0;
+    uint16_t frame_time_remainder_us = 0;
+    FFT *audio_input = nullptr;
+    uint32_t audio_time_delta_us = 0;
+    audio_features audio;
+
+    void update_audio_features(uint32_t time_delta_us);
+
+    bool frame_clock_active() {return frame_clock.divider && timer1::IsRunning();}
+
+    bool dispatch_events();
+
+    uint16_t show_strips();
+
     bool _add_ledstrip(
         sl_list::node<ledStrip> &ledstrip_node,
         CRGB *pixel_array,
@@ -53,11 +129,93 @@ public:
 
     bool update();
 
+    void idle();
+
+    void set_frame_rate(uint16_t fps);
+
+    bool set_frame_clock(uint16_t fps);
+
+    void set_audio_input(FFT *fft);
+
+    /**
+     * @brief Returns the audio features of the latest frame
+     * 
+     * @return const audio_features& 
+     */
+    const audio_features &get_audio_features() {return audio;}
+
+    void set_quality_governor(bool enable);
+
+    void set_quality_level(quality_level level);
+
+    /**
+     * @brief Returns the quality level set by the governor
+     * 
+     * @return quality_level 
+     */
+    quality_level get_quality_level() {return quality;}
+
+    /**
+     * @brief Returns the number of frames run
+     * 
+     * @return uint32_t 
+     */
+    uint32_t get_frame_number() {return frame_number;}
+
+    void print_profile(bool reset = 1);
+
+    /**
+     * @brief Queues an event for the subscribed effects. Callable from isrs.
+     *      e.g. post_event(event_serial_command, Serial.read()) in serialEvent()
+     * 
+     * @param type 
+     * @param data 
+     * @return true queue is full, event was dropped
+     * @return false 
+     */
+    bool post_event(event_type type, uint8_t data = 0) {return event_bus.post(type, data);}
+
+    /**
+     * @brief Holds back led output while the sampler fills a window.
+     *      The changes are pushed on the first update() call after the window is full.
+     *      Output is forced once it has waited for the length of one window.
+     * @note Fixed8MultiResFFT is synced to its short window
+     * 
+     * @param enable 
+     */
+    void set_sampler_sync(bool enable) {sampler_sync = enable;}
+
+    /**
+     * @brief Makes the fft backend sample a window again when led output
+     *      blocked the sampling isr for longer than a sample period during it.
+     *      Off by default, such windows are only counted
+     * @note Only the windows which were filling are discarded
+     * 
+     * @param enable 
+     */
+    void set_discard_corrupted_windows(bool enable) {discard_corrupted_windows = enable;}
+
+    /**
+     * @brief Returns the number of led pushes which blocked a filling window 
+     *      for longer than a sample period
+     * 
+     * @return uint16_t 
+     */
+    uint16_t get_corrupted_windows() {return corrupted_windows;}
+
+    uint16_t get_late_samples();
+
+    void reset_sampler_stats();
+
     bool add_led_strip(
         ledStrip &led_strip,
         CRGB *pixel_array,
         const uint16_t array_size);
 
+    bool add_led_strip(
+        ledStrip &led_strip,
+        CLEDController &controller);
+
     bool add_effect(
         ledStrip &led_strip,
         audioMode &audio_effect,
@@ -68,11 +226,34 @@ public:
         ledStrip &ledstrip,
         audioMode &effect_node);
 
+    /*
+     * Layers are blended in the post processing pass. They need the strip added with 
+     * its own CLEDController & enable_post_processing(), which costs a full output buffer
+     * (3 bytes per led) on top of the layer buffer, and the strip skips FastLED.show().
+     * Effects which only need a pixel range of the strip can use add_effect() instead
+     */
+    bool add_layer(
+        ledStrip &led_strip,
+        audioMode &audio_effect,
+        CRGB *pixel_start,
+        CRGB *pixel_end,
+        CRGB *layer_buffer,
+        blend_mode mode,
+        uint8_t z_order,
+        uint8_t alpha = 255);
+
 
     bool remove_effect(
         ledStrip &ledstrip,
         audioMode &audio_effect);
 
+    bool transition(
+        ledStrip &led_strip,
+        audioMode &outgoing,
+        audioMode &incoming,
+        CRGB *buffer,
+        uint16_t duration_ms);
+
     bool remove_effect(audioMode &audio_effect);
 };
 
@@ -9,6 +9,85 @@
 #define NUM_OF_MODES 1 // Number of modes
 
 #define NUM_OF_PALETTES 1 // Number of color palettes
+
+/**
+ * @brief fixed_8_multires fft backend settings
+ * @note Long window is sample_size samples decimated by 2^MULTIRES_DECIMATION_SHIFT.
+ *       Short window is sample_size >> MULTIRES_SHORT_WINDOW_SHIFT samples at full sampling frequency.
+ */
+#define MULTIRES_DECIMATION_SHIFT 2
+#define MULTIRES_SHORT_WINDOW_SHIFT 1
+
+/**
+ * @brief Attack & release times in ms for the FFT's loudness envelope
+ *
+ */
+#define AUDIO_ENVELOPE_ATTACK_MS 5
+#define AUDIO_ENVELOPE_RELEASE_MS 150
+
+/* Max number of sine tones in synthetic_audio_source */
+#define SYNTHETIC_SOURCE_MAX_TONES 3
+
+/* Max number of blended layers per led strip. See ledStrip::add_layer() */
+#define MAX_LAYERS 4
+
+/**
+ * @brief Current draw model for the led strip's current limiter.
+ *      Channel at full brightness draws LED_CHANNEL_MA. 
+ *      Each led draws LED_IDLE_MA when black. Values for WS2812B
+ */
+#define LED_CHANNEL_MA 20
+#define LED_IDLE_MA 1
+
+/**
+ * @brief Pixels per cached channel sum in the led strip's current estimate.
+ *      Only blocks overlapping changed pixels are summed again. Max 85
+ */
+#define CURRENT_ESTIMATE_BLOCK_SIZE 16
+
+/**
+ * @brief 1 to count samples the sampling isr took over half a sample period late.
+ *      Read with led_manager::get_late_samples()
+ */
+#define CONF_SAMPLER_STATS 0
+
+/**
+ * @brief Events queued between led_manager::update() calls. Power of two, max 128.
+ *      Events posted to a full queue are dropped
+ */
+#define EVENT_QUEUE_SIZE 8
+
+/**
+ * @brief Quality governor, see led_manager::set_quality_governor().
+ *      Quality is lowered after GOVERNOR_OVERRUN_FRAMES consecutive frames over the frame period
+ *      and raised after GOVERNOR_RESTORE_FRAMES consecutive frames 
+ *      under GOVERNOR_HEADROOM_PERCENT of the frame period
+ */
+#define GOVERNOR_OVERRUN_FRAMES 4
+#define GOVERNOR_RESTORE_FRAMES 120
+#define GOVERNOR_HEADROOM_PERCENT 60
+
+/**
+ * @brief 1 to let led_manager::set_frame_clock() bind timer1's compare A interrupt through rISR.
+ *      0 leaves TIMER1_COMPA_vect free for the sketch
+ * @note The frame clock's compare A interrupt fires on every sampling period, 
+ *       only to count down the frame divider
+ */
+#define CONF_ENABLE_FRAME_CLOCK 0
+
+/**
+ * @brief 1 to time effects, FFT::calculate() and led output.
+ *      Dump with led_manager::print_profile().
+ * @note 0 compiles the profiler out completely
+ */
+#define CONF_ENABLE_PROFILER 0
+
+/**
+ * @brief Frame & output time histogram.
+ *      Bin width is 2^PROFILER_HISTOGRAM_SHIFT us
+ */
+#define PROFILER_HISTOGRAM_BINS 8
+#define PROFILER_HISTOGRAM_SHIFT 11
 /*-------------*/
 
 /**
@@ -445,9 +445,11 @@ uint16_t modulus(fixed8_t x[], int size, float frequency)
     return i_maxi * frequency / size;
 }
 
-Fixed8FFT::Fixed8FFT(uint8_t input_pin, uint16_t sample_size, uint16_t frequency, fft_backend backend)
+Fixed8FFT::Fixed8FFT(uint8_t input_pin, uint16_t sample_size, uint16_t frequency, fft_backend backend, adc_mode mode)
 : FFT_backend_template( input_pin )
 {
+    m_adc_mode = mode;
+
     /* Validate sample_size */
     if (get_power_of_two(sample_size) == 0)
     { 
@@ -465,10 +467,22 @@ Fixed8FFT::Fixed8FFT(uint8_t input_pin, uint16_t sample_size, uint16_t frequency
     cli();
     interrupt_data.data = reinterpret_cast<int8_t *>(m_data);
     interrupt_data.array_pos = 0;
+    fft_window_filling = fft_primary_window;
+    fft_window_samples = m_sample_size;
     interrupt_data.adc_pin = input_pin;
     interrupt_data.offset_x = 70;
     interrupt_data.scale_x = 4;
     interrupt_data.array_size = get_power_of_two(sample_size);
+    interrupt_data.fast_adc = 0;
+
+    /* Full adc range maps to int8_t. Equals to scale_x of 16 */
+    if (mode == adc_8bit_fast)
+    {
+        interrupt_data.scale_x = 16;
+        interrupt_data.fast_adc = 1;
+    }
+
+    set_adc_mode(mode);
     sei();
     return;
 }
@@ -494,41 +508,82 @@ void Fixed8FFT::deallocate_data_array()
     return;
 }
 
+/**
+ * @brief Changes the window size & restarts sampling
+ * @note Keeps the old size if the new window can't be allocated
+ *
+ * @param sample_size power of two
+ * @return true failed. Sample size is unchanged, or 0 if the old window couldn't be reallocated either
+ * @return false 
+ */
 bool Fixed8FFT::set_sample_size(uint16_t sample_size)
 {
+    uint16_t old_size = m_sample_size;
+
     if (m_sample_size == sample_size)
         return 1;
 
     if (get_power_of_two(sample_size) == 0)
         return 1;
 
-    m_sample_size = sample_size;
-
     cli();
     deallocate_data_array();
+    m_sample_size = sample_size;
 
     if (!allocate_data_array())
     {
-        interrupt_data.array_size = 0;
-        interrupt_data.array_pos = 0;
-        m_sample_size = 0;
-        return 1;
+        /* Keep sampling with the old size. Its block was just freed */
+        m_sample_size = old_size;
+
+        if (old_size == 0 || !allocate_data_array())
+        {
+            /* Window stays full so the isr doesn't write anywhere */
+            interrupt_data.data = nullptr;
+            interrupt_data.array_size = 0;
+            interrupt_data.array_pos = 1;
+            fft_window_filling = 0;
+            fft_window_samples = 0;
+            m_sample_size = 0;
+            sei();
+            return 1;
+        }
     }
 
-    interrupt_data.array_size = get_power_of_two(sample_size);
+    interrupt_data.data = reinterpret_cast<int8_t *>(m_data);
+    interrupt_data.array_size = get_power_of_two(m_sample_size);
     interrupt_data.array_pos = 0;
+    fft_window_filling = m_audio_source == nullptr ? fft_primary_window : 0;
+    fft_window_samples = m_sample_size;
 
     sei();
-    return 0;
+    return m_sample_size != sample_size;
 }
 
 uint16_t Fixed8FFT::calculate()
 {
+    /* set_sample_size() failed to allocate a window */
+    if (m_data == nullptr)
+        return 0;
+
+    if (m_audio_source != nullptr)
+        read_audio_source();
+
     if (interrupt_data.array_pos == 1 << interrupt_data.array_size)
     {
         uint16_t temp = 0;
 
-        if (millis() - last_result_time < 250)
+        /* Led output blocked the sampling isr for longer than a sample period. Sample again */
+        if ((fft_window_corrupted & fft_primary_window) && m_audio_source == nullptr)
+        {
+            cli();
+            fft_window_corrupted &= ~fft_primary_window;
+            fft_window_filling |= fft_primary_window;
+            interrupt_data.array_pos = 0;
+            sei();
+            return 0;
+        }
+
+        if (millis() - last_result_time < 250 && m_adc_mode == adc_10bit && m_audio_source == nullptr)
         {
             calculate_scaling();
             last_result_time = millis();
@@ -537,14 +592,56 @@ uint16_t Fixed8FFT::calculate()
         fft(interrupt_data.data, m_sample_size);
 
         temp = modulus(interrupt_data.data, m_sample_size, m_sampling_frequency);
+
+        /* modulus() leaves the magnitudes in the first half of the array */
+        if (m_spectrum_sink != nullptr)
+            m_spectrum_sink->push_spectrum(reinterpret_cast<uint8_t *>(interrupt_data.data), m_sample_size / 2);
+
         cli();
         interrupt_data.array_pos = 0;
+        fft_window_filling = m_audio_source == nullptr ? fft_primary_window : 0;
         sei();
         return temp;
     }
     return 0;
 }
 
+void Fixed8FFT::read_audio_source()
+{
+    uint16_t pos = interrupt_data.array_pos;
+    uint16_t count = 0;
+
+    if (pos >= m_sample_size)
+        return;
+
+    count = m_audio_source->read(&interrupt_data.data[pos], m_sample_size - pos);
+
+    for (uint16_t i = pos; i < pos + count; i++)
+        accumulate_adc_level(interrupt_data.level, interrupt_data.data[i]);
+
+    interrupt_data.array_pos = pos + count;
+}
+
+void Fixed8FFT::set_audio_source(audio_source *source)
+{
+    m_audio_source = source;
+
+    /* Sources produce full scale int8_t samples. Equals to scale_x of 16 */
+    if (source != nullptr)
+    {
+        interrupt_data.scale_x = 16;
+
+        /* Sampling isr doesn't block on led output anymore */
+        fft_window_filling = 0;
+    }
+}
+
+volatile bool fft_window_complete = 0;
+volatile uint8_t fft_window_filling = 0;
+volatile uint8_t fft_window_corrupted = 0;
+uint16_t fft_window_samples = 0;
+volatile uint16_t fft_late_samples = 0;
+
 __attribute__((signal)) void __vector_timer1_compb_adc_read_byte()
 {
     adc_sample_interrupt *data = (struct adc_sample_interrupt*) get_isr_data_ptr(TIMER1_COMPB_ptr);
@@ -555,25 +652,82 @@ __attribute__((signal)) void __vector_timer1_compb_adc_read_byte()
         return;
     }
 
-    ADMUX = (1 << 6) | (data->adc_pin & 0x15);
-
-    /* Start conversion */
-    _SFR_BYTE(ADCSRA) |= _BV(ADSC);
-
-    /* Adc is cleared when conversion finishes */
-    while (bit_is_set(ADCSRA, ADSC))
-        ;
-    /* Calculate the scaling values */
-    uint16_t min_val = constrain(data->offset_x * 8 - data->scale_x * 32, 0, 1024);
-    uint16_t max_val = constrain(data->offset_x * 8 + data->scale_x * 32, 0, 1024);
+    count_late_sample();
 
     /* Scale the adc reading to best fit in uint8_t. Then save it */
-    data->data[data->array_pos] = map(constrain(ADC, min_val, max_val), min_val, max_val, -128, 127);
+    if (data->fast_adc)
+        data->data[data->array_pos] = adc_read_fast_sample(data->adc_pin);
+    else
+        data->data[data->array_pos] = adc_read_scaled_sample(data->adc_pin, data->offset_x, data->scale_x);
+
+    accumulate_adc_level(data->level, data->data[data->array_pos]);
     data->array_pos += 1;
+
+    if (data->array_pos >= 1 << data->array_size)
+    {
+        fft_window_complete = 1;
+        fft_window_filling &= ~fft_primary_window;
+        event_bus.post(event_window_ready);
+    }
+
     return;
 }
 
 
+void set_adc_mode(adc_mode mode)
+{
+    /* Clear prescaler bits */
+    ADCSRA &= ~((1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0));
+
+    switch (mode)
+    {
+    case adc_8bit_fast:
+        /* Prescaler 16 -> 1 MHz adc clock */
+        ADCSRA |= (1 << ADPS2);
+        break;
+
+    default:
+        /* Prescaler 128 -> 125 kHz adc clock. Arduino's default */
+        ADCSRA |= (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0);
+        break;
+    }
+}
+
+bool read_adc_level(adc_level_accumulator &level, uint8_t scale_x, uint16_t &peak, uint16_t &rms)
+{
+    uint32_t sum_sq;
+    int16_t sum;
+    int8_t min_val;
+    int8_t max_val;
+    uint8_t count;
+    int32_t variance;
+
+    cli();
+    sum_sq = level.sum_sq;
+    sum = level.sum;
+    min_val = level.min;
+    max_val = level.max;
+    count = level.count;
+
+    level.sum_sq = 0;
+    level.sum = 0;
+    level.count = 0;
+    sei();
+
+    if (count == 0)
+        return 0;
+
+    /* E[x²] - E[x]² removes the dc offset */
+    variance = sum_sq / count - ((int32_t) sum * sum) / ((int32_t) count * count);
+    if (variance < 0)
+        variance = 0;
+
+    /* int8_t range of 256 covers scale_x * 64 adc units */
+    peak = ((uint16_t) (max_val - min_val) * scale_x) >> 3;
+    rms = ((uint16_t) sqrt16(variance) * scale_x) >> 2;
+    return 1;
+}
+
 /* 
  * Internal definitions for calculate_scaling() 
  * 
@@ -584,11 +738,8 @@ __attribute__((signal)) void __vector_timer1_compb_adc_read_byte()
 #define Fixed8FFT_min_dynamic_range 200
 #define Fixed8FFT_optimal_dynamic_range8bit 230
 
-void Fixed8FFT::calculate_scaling()
+void calculate_adc_scaling(const int8_t *data, uint16_t size, uint8_t &offset_x, uint8_t &scale_x)
 {
-    if (interrupt_data.array_pos != 1 << interrupt_data.array_size)
-        return;
-
     int16_t highest = -128;
     int16_t lowest = 127;
     int32_t average = 0;
@@ -597,30 +748,29 @@ void Fixed8FFT::calculate_scaling()
 
     //int16_t real_highest = 0;
     //int16_t real_lowest = 0;
-    cli();
 
     /* Calculate avarage, highest & lowest values */
-    for (uint16_t i = 0; i < m_sample_size; i++)
+    for (uint16_t i = 0; i < size; i++)
     {
-        average += reinterpret_cast<int8_t *>(m_data)[i];
+        average += data[i];
 
-        if (reinterpret_cast<int8_t *>(m_data)[i] > highest)
-            highest = reinterpret_cast<int8_t *>(m_data)[i];
+        if (data[i] > highest)
+            highest = data[i];
 
-        if (reinterpret_cast<int8_t *>(m_data)[i] < lowest)
-            lowest = reinterpret_cast<int8_t *>(m_data)[i];
+        if (data[i] < lowest)
+            lowest = data[i];
     }
     
     used_dynamic_range = highest - lowest;
 
     /*
     real_lowest = map(lowest, -128, 127,
-                      (interrupt_data.offset_x * 8 - interrupt_data.scale_x * 32),
-                      (interrupt_data.offset_x * 8 + interrupt_data.scale_x * 32));
+                      (offset_x * 8 - scale_x * 32),
+                      (offset_x * 8 + scale_x * 32));
 
     real_highest = map(highest, -128, 127,
-                       (interrupt_data.offset_x * 8 - interrupt_data.scale_x * 32),
-                       (interrupt_data.offset_x * 8 + interrupt_data.scale_x * 32));
+                       (offset_x * 8 - scale_x * 32),
+                       (offset_x * 8 + scale_x * 32));
 
     real_dynamic_range = real_highest - real_lowest;
     */
@@ -630,49 +780,64 @@ void Fixed8FFT::calculate_scaling()
     {
         /* Calculate optimal value for offset_x. */
         /* aka try to place offset_x in the middle of the signal */
-        average /= m_sample_size;
+        average /= size;
         // INFO(F("Average: "), average);
 
         /* Convert average from -128-127 to original adc reading */
         average = map(average, -128, 127,
-                      (interrupt_data.offset_x * 8 - interrupt_data.scale_x * 32),
-                      (interrupt_data.offset_x * 8 + interrupt_data.scale_x * 32));
+                      (offset_x * 8 - scale_x * 32),
+                      (offset_x * 8 + scale_x * 32));
 
         // INFO(F("Real average: "), average);
         /* Calculate offset */
-        average = average - interrupt_data.offset_x * 8;
+        average = average - offset_x * 8;
         // INFO(F("Offset fix: "), average);
 
-        average = interrupt_data.offset_x + average;
+        average = offset_x + average;
         // INFO(F("New average: "), average);
 
         /* Check if new range is under 0*/
         if (map(-128, -128, 127,
-                (average * 8 - interrupt_data.scale_x * 32),
-                (average * 8 + interrupt_data.scale_x * 32)) < 0)
+                (average * 8 - scale_x * 32),
+                (average * 8 + scale_x * 32)) < 0)
             goto skip_offset;
 
         /* Check if new range is over 1024*/
         if (map(127, -128, 127,
-                (average * 8 - interrupt_data.scale_x * 32),
-                (average * 8 + interrupt_data.scale_x * 32)) > 1024)
+                (average * 8 - scale_x * 32),
+                (average * 8 + scale_x * 32)) > 1024)
             goto skip_offset;
 
-        interrupt_data.offset_x = constrain(average, 0, 128);
-        // DEBUG(F("New offset: "), (uint16_t) interrupt_data.offset_x);
+        offset_x = constrain(average, 0, 128);
+        // DEBUG(F("New offset: "), (uint16_t) offset_x);
     }
 skip_offset:
 
     if (used_dynamic_range > 230)
     {
-        interrupt_data.scale_x = constrain(interrupt_data.scale_x + 1, 0, 16);
-        // DEBUG(F("SCALE_X: "), (uint8_t) interrupt_data.scale_x);
+        scale_x = constrain(scale_x + 1, 0, 16);
+        // DEBUG(F("SCALE_X: "), (uint8_t) scale_x);
     }
     else if (used_dynamic_range < Fixed8FFT_optimal_dynamic_range8bit)
     {
-        interrupt_data.scale_x = constrain(interrupt_data.scale_x - 1, 5, 16);
-        // DEBUG(F("SCALE_X: "), (uint8_t) interrupt_data.scale_x);
+        scale_x = constrain(scale_x - 1, 5, 16);
+        // DEBUG(F("SCALE_X: "), (uint8_t) scale_x);
     }
+    return;
+}
+
+void Fixed8FFT::calculate_scaling()
+{
+    if (interrupt_data.array_pos != 1 << interrupt_data.array_size)
+        return;
+
+    cli();
+    uint8_t offset_x = interrupt_data.offset_x;
+    uint8_t scale_x = interrupt_data.scale_x;
+
+    calculate_adc_scaling(reinterpret_cast<int8_t *>(m_data), m_sample_size, offset_x, scale_x);
+    interrupt_data.offset_x = offset_x;
+    interrupt_data.scale_x = scale_x;
     sei();
     return;
 }
@@ -704,6 +869,11 @@ uint8_t Fixed8FFT::get_power_of_two(uint16_t value)
     return 0;
 }
 
+bool Fixed8FFT::read_level(uint16_t &peak, uint16_t &rms)
+{
+    return read_adc_level(interrupt_data.level, interrupt_data.scale_x, peak, rms);
+}
+
 vector_t Fixed8FFT::get_read_vector()
 {
     return __vector_timer1_compb_adc_read_byte;
@@ -718,6 +888,9 @@ void *Fixed8FFT::get_read_vector_data_pointer()
 
 Fixed8FFT::~Fixed8FFT()
 {
+    if (m_adc_mode != adc_10bit)
+        set_adc_mode(adc_10bit);
+
     deallocate_data_array();
     return;
 }
\ No newline at end of file
@@ -98,12 +98,146 @@ extern fixed8_t fixed_add_saturate_8_8(fixed8_t a, fixed8_t b);
  */
 extern fixed16_t fixed_add_saturate_16_16(fixed16_t a, fixed16_t b);
 
+/**
+ * @brief Adjusts the adc offset & scale values to fit the sampled signal
+ *      into the int8_t range
+ *
+ * @param data sampled window
+ * @param size window size
+ * @param offset_x
+ * @param scale_x
+ */
+extern void calculate_adc_scaling(const int8_t *data, uint16_t size, uint8_t &offset_x, uint8_t &scale_x);
+
+/**
+ * @brief Blocking adc read scaled to int8_t with the offset & scale values.
+ *      Used by the sampling isrs.
+ *
+ * @param adc_pin
+ * @param offset_x
+ * @param scale_x
+ * @return int8_t
+ */
+__attribute__((always_inline)) static inline int8_t adc_read_scaled_sample(uint8_t adc_pin, uint8_t offset_x, uint8_t scale_x)
+{
+    ADMUX = (1 << 6) | (adc_pin & 0x15);
+
+    /* Start conversion */
+    _SFR_BYTE(ADCSRA) |= _BV(ADSC);
+
+    /* Adc is cleared when conversion finishes */
+    while (bit_is_set(ADCSRA, ADSC))
+        ;
+    /* Calculate the scaling values */
+    uint16_t min_val = constrain(offset_x * 8 - scale_x * 32, 0, 1024);
+    uint16_t max_val = constrain(offset_x * 8 + scale_x * 32, 0, 1024);
+
+    return map(constrain(ADC, min_val, max_val), min_val, max_val, -128, 127);
+}
+
+/**
+ * @brief Fast adc read of the left adjusted 8 bit result.
+ *      Used by the sampling isrs in adc_8bit_fast mode.
+ *
+ * @param adc_pin
+ * @return int8_t adc reading centered around 0
+ */
+__attribute__((always_inline)) static inline int8_t adc_read_fast_sample(uint8_t adc_pin)
+{
+    ADMUX = (1 << 6) | (1 << ADLAR) | (adc_pin & 0x0F);
+
+    /* Start conversion */
+    _SFR_BYTE(ADCSRA) |= _BV(ADSC);
+
+    /* Adc is cleared when conversion finishes */
+    while (bit_is_set(ADCSRA, ADSC))
+        ;
+
+    return (int8_t) (ADCH ^ 0x80);
+}
+
+/**
+ * @brief Configures the adc prescaler for the adc mode
+ *
+ * @param mode
+ */
+extern void set_adc_mode(adc_mode mode);
+
 /**
  * @brief Isr for reading 8bit adc value using timer1 compb interrupt
  *
  */
 extern void __vector_timer1_compb_adc_read_byte();
 
+#ifndef _FIXED8FFT_ADC_LEVEL_ACCUMULATOR_STRUCT_
+#define _FIXED8FFT_ADC_LEVEL_ACCUMULATOR_STRUCT_
+
+/**
+ * @brief Signal level statistics gathered by the sampling isr
+ *      between two read_adc_level() calls.
+ *
+ */
+struct adc_level_accumulator
+{
+    volatile uint32_t sum_sq = 0;
+    volatile int16_t sum = 0;
+    volatile int8_t min = 0;
+    volatile int8_t max = 0;
+    volatile uint8_t count = 0;
+};
+#endif
+
+/**
+ * @brief Counts the sample if the isr started over half a sample period late.
+ *      Called from the sampling isrs before the adc read.
+ * @note timer1 compare B matches when TCNT1 is 0, so TCNT1 is the isr's latency in timer ticks.
+ *       Samples lost during a longer block aren't seen, only the late one after it.
+ */
+__attribute__((always_inline)) static inline void count_late_sample()
+{
+#if CONF_SAMPLER_STATS == 1
+    if (TCNT1 > (OCR1A >> 1))
+        fft_late_samples++;
+#endif
+}
+
+/**
+ * @brief Adds the sample to the level statistics. Called from the sampling isrs.
+ *
+ * @param level
+ * @param sample
+ */
+__attribute__((always_inline)) static inline void accumulate_adc_level(adc_level_accumulator &level, int8_t sample)
+{
+    /* Saturated. Wait for read_adc_level() */
+    if (level.count == 255)
+        return;
+
+    level.sum += sample;
+    level.sum_sq += (int16_t) sample * sample;
+
+    if (level.count == 0 || sample < level.min)
+        level.min = sample;
+
+    if (level.count == 0 || sample > level.max)
+        level.max = sample;
+
+    level.count += 1;
+}
+
+/**
+ * @brief Reads & resets the level statistics.
+ *      Levels are converted from the scaled int8_t samples back to adc units.
+ *
+ * @param level
+ * @param scale_x current scale value of the sampling isr
+ * @param peak half of the peak to peak amplitude
+ * @param rms rms amplitude without dc
+ * @return true new samples were available
+ * @return false no samples since the last read
+ */
+extern bool read_adc_level(adc_level_accumulator &level, uint8_t scale_x, uint16_t &peak, uint16_t &rms);
+
 #ifndef _FIXED8FFT_ADC_SAMPLE_INTERRUPT_STRUCT_
 #define _FIXED8FFT_ADC_SAMPLE_INTERRUPT_STRUCT_
 
@@ -122,10 +256,15 @@ struct adc_sample_interrupt
         /* Values to scale the input data */
         volatile uint32_t offset_x : 7;
         volatile uint32_t scale_x : 5;
+
+        volatile uint32_t fast_adc : 1;  // adc_8bit_fast mode
     };
 
     /* pointer to int8_t array */
     int8_t *volatile data;
+
+    /* Signal level of the samples */
+    adc_level_accumulator level;
 };
 #endif
 
@@ -143,15 +282,23 @@ private:
     void calculate_scaling();
     uint8_t get_power_of_two(uint16_t value);
 
+    /**
+     * @brief Fills the rest of the window from the audio source
+     *
+     */
+    void read_audio_source();
+
 protected:
     bool allocate_data_array() override;
     void deallocate_data_array() override;
 
 public:
-    Fixed8FFT(uint8_t input_pin, uint16_t sample_size, uint16_t frequency, fft_backend bits);
+    Fixed8FFT(uint8_t input_pin, uint16_t sample_size, uint16_t frequency, fft_backend bits, adc_mode mode = adc_10bit);
     uint16_t calculate() override;
 
     bool set_sample_size(uint16_t sample_size) override;
+    bool read_level(uint16_t &peak, uint16_t &rms) override;
+    void set_audio_source(audio_source *source) override;
     vector_t get_read_vector() override;
     void *get_read_vector_data_pointer() override;
     ~Fixed8FFT();
@@ -0,0 +1,455 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Mikko Johannes Heinänen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "Fixed8MultiResFFT.h"
+
+Fixed8MultiResFFT::Fixed8MultiResFFT(uint8_t input_pin, uint16_t sample_size, uint8_t short_window_shift, uint8_t decimation_shift, adc_mode mode)
+: FFT_backend_template(sample_size),
+  m_short_window_shift(short_window_shift),
+  m_decimation_shift(decimation_shift)
+{
+    m_adc_mode = mode;
+
+    update_sizes(sample_size);
+
+    /* Validate sample sizes */
+    if (sample_size == 0 || (sample_size & (sample_size - 1)) != 0 || m_short_size < 2)
+    {
+        ERROR(F("Fixed8MultiResFFT: invalid sample size: "), sample_size);
+        clear_sizes();
+        return;
+    }
+
+    if (!allocate_data_array())
+    {
+        clear_sizes();
+        return;
+    }
+
+    cli();
+    interrupt_data.long_data = reinterpret_cast<int8_t *>(m_data);
+    interrupt_data.short_data = m_short_data;
+    interrupt_data.long_size = m_sample_size;
+    interrupt_data.short_size = m_short_size;
+    interrupt_data.long_pos = 0;
+    interrupt_data.short_pos = 0;
+    interrupt_data.long_accumulator = 0;
+    interrupt_data.decimation_pos = 0;
+    fft_window_filling = fft_primary_window | fft_long_window;
+    fft_window_samples = m_short_size;
+    interrupt_data.decimation_shift = decimation_shift;
+    interrupt_data.adc_pin = input_pin;
+    interrupt_data.offset_x = 70;
+    interrupt_data.scale_x = 4;
+    interrupt_data.fast_adc = 0;
+
+    /* Full adc range maps to int8_t. Equals to scale_x of 16 */
+    if (mode == adc_8bit_fast)
+    {
+        interrupt_data.scale_x = 16;
+        interrupt_data.fast_adc = 1;
+    }
+
+    set_adc_mode(mode);
+    sei();
+    return;
+}
+
+/**
+ * @brief Calculates the short window & merged view sizes for the sample_size
+ *
+ * @param sample_size long window size
+ */
+void Fixed8MultiResFFT::update_sizes(uint16_t sample_size)
+{
+    m_sample_size = sample_size;
+    m_short_size = sample_size >> m_short_window_shift;
+
+    /* First short window bin above the long window's nyquist frequency */
+    m_crossover_bin = m_short_size >> (m_decimation_shift + 1);
+    if (m_crossover_bin == 0)
+        m_crossover_bin = 1;
+
+    m_band_count = m_sample_size / 2 + m_short_size / 2 - m_crossover_bin;
+}
+
+/**
+ * @brief Zeroes the sizes of both windows, so the isr & calculate() won't touch the data arrays.
+ *      Restores the caller's interrupt state, so it can run inside a cli() block
+ *
+ */
+void Fixed8MultiResFFT::clear_sizes()
+{
+    uint8_t sreg = SREG;
+
+    cli();
+    m_sample_size = 0;
+    m_short_size = 0;
+    m_band_count = 0;
+    m_crossover_bin = 0;
+
+    interrupt_data.long_data = nullptr;
+    interrupt_data.short_data = nullptr;
+    interrupt_data.long_size = 0;
+    interrupt_data.short_size = 0;
+    interrupt_data.long_pos = 0;
+    interrupt_data.short_pos = 0;
+    fft_window_filling = 0;
+    SREG = sreg;
+}
+
+bool Fixed8MultiResFFT::allocate_data_array()
+{
+    m_data = calloc(m_sample_size, sizeof(fixed8_t));
+    m_short_data = reinterpret_cast<int8_t *>(calloc(m_short_size, sizeof(fixed8_t)));
+    m_bands = reinterpret_cast<uint8_t *>(calloc(m_band_count, sizeof(uint8_t)));
+
+    if (m_data != nullptr && m_short_data != nullptr && m_bands != nullptr)
+        return 1;
+
+    ERROR(F("Fixed8MultiResFFT: Failed to allocate data arrays. Size: "),
+          sizeof(fixed8_t) * (m_sample_size + m_short_size) + m_band_count,
+          F(" bytes"));
+
+    deallocate_data_array();
+    return 0;
+}
+
+void Fixed8MultiResFFT::deallocate_data_array()
+{
+    free(m_data);
+    free(m_short_data);
+    free(m_bands);
+
+    m_data = nullptr;
+    m_short_data = nullptr;
+    m_bands = nullptr;
+    return;
+}
+
+bool Fixed8MultiResFFT::set_sample_size(uint16_t sample_size)
+{
+    uint16_t old_size = m_sample_size;
+
+    if (m_sample_size == sample_size)
+        return 1;
+
+    if (sample_size == 0 || (sample_size & (sample_size - 1)) != 0 || (sample_size >> m_short_window_shift) < 2)
+    {
+        ERROR(F("Fixed8MultiResFFT: invalid sample size: "), sample_size);
+        return 1;
+    }
+
+    cli();
+    deallocate_data_array();
+    update_sizes(sample_size);
+
+    if (!allocate_data_array())
+    {
+        /* Keep sampling with the old size. Its blocks were just freed */
+        update_sizes(old_size);
+
+        if (old_size == 0 || !allocate_data_array())
+        {
+            clear_sizes();
+            sei();
+            return 1;
+        }
+    }
+
+    interrupt_data.long_data = reinterpret_cast<int8_t *>(m_data);
+    interrupt_data.short_data = m_short_data;
+    interrupt_data.long_size = m_sample_size;
+    interrupt_data.short_size = m_short_size;
+    interrupt_data.long_pos = 0;
+    interrupt_data.short_pos = 0;
+    interrupt_data.long_accumulator = 0;
+    interrupt_data.decimation_pos = 0;
+    fft_window_filling = m_audio_source == nullptr ? fft_primary_window | fft_long_window : 0;
+    fft_window_samples = m_short_size;
+    sei();
+    return m_sample_size != sample_size;
+}
+
+/**
+ * @brief Calculates the fft for the windows which are filled.
+ *
+ * @return uint16_t loudest frequency of the merged view. 0 if no window was ready
+ */
+uint16_t Fixed8MultiResFFT::calculate()
+{
+    bool updated = 0;
+    uint8_t loudest = 0;
+    uint16_t loudest_band = 0;
+
+    /* Allocation failed. Windows are never filled */
+    if (m_data == nullptr)
+        return 0;
+
+    if (m_audio_source != nullptr)
+        read_audio_source();
+
+    /* Led output blocked the sampling isr for longer than a sample period. Sample the hit windows again */
+    if ((fft_window_corrupted & fft_primary_window) && interrupt_data.short_pos == m_short_size && m_audio_source == nullptr)
+    {
+        cli();
+        fft_window_corrupted &= ~fft_primary_window;
+        fft_window_filling |= fft_primary_window;
+        interrupt_data.short_pos = 0;
+        sei();
+    }
+
+    if ((fft_window_corrupted & fft_long_window) && interrupt_data.long_pos == m_sample_size && m_audio_source == nullptr)
+    {
+        cli();
+        fft_window_corrupted &= ~fft_long_window;
+        fft_window_filling |= fft_long_window;
+        interrupt_data.long_pos = 0;
+        interrupt_data.long_accumulator = 0;
+        interrupt_data.decimation_pos = 0;
+        sei();
+    }
+
+    if (interrupt_data.short_pos == m_short_size)
+    {
+        /* Short window has the raw samples. Use it to keep the adc range in check */
+        if (millis() - last_scaling_time >= 250 && m_adc_mode == adc_10bit && m_audio_source == nullptr)
+        {
+            calculate_scaling();
+            last_scaling_time = millis();
+        }
+
+        fft(m_short_data, m_short_size);
+        modulus(m_short_data, m_short_size, m_sampling_frequency);
+        memcpy(&m_bands[m_sample_size / 2], &m_short_data[m_crossover_bin], m_short_size / 2 - m_crossover_bin);
+
+        cli();
+        interrupt_data.short_pos = 0;
+        if (m_audio_source == nullptr)
+            fft_window_filling |= fft_primary_window;
+        sei();
+        updated = 1;
+    }
+
+    if (interrupt_data.long_pos == m_sample_size)
+    {
+        fft(reinterpret_cast<int8_t *>(m_data), m_sample_size);
+        modulus(reinterpret_cast<int8_t *>(m_data), m_sample_size, m_sampling_frequency >> m_decimation_shift);
+        memcpy(m_bands, m_data, m_sample_size / 2);
+
+        cli();
+        interrupt_data.long_pos = 0;
+        if (m_audio_source == nullptr)
+            fft_window_filling |= fft_long_window;
+        sei();
+        updated = 1;
+    }
+
+    if (!updated)
+        return 0;
+
+    if (m_spectrum_sink != nullptr)
+        m_spectrum_sink->push_spectrum(m_bands, m_band_count);
+
+    /* Skip the dc band */
+    for (uint16_t i = 1; i < m_band_count; i++)
+    {
+        if (m_bands[i] > loudest)
+        {
+            loudest = m_bands[i];
+            loudest_band = i;
+        }
+    }
+
+    return get_band_frequency(loudest_band);
+}
+
+void Fixed8MultiResFFT::calculate_scaling()
+{
+    cli();
+    uint8_t offset_x = interrupt_data.offset_x;
+    uint8_t scale_x = interrupt_data.scale_x;
+
+    calculate_adc_scaling(m_short_data, m_short_size, offset_x, scale_x);
+    interrupt_data.offset_x = offset_x;
+    interrupt_data.scale_x = scale_x;
+    sei();
+}
+
+uint16_t Fixed8MultiResFFT::get_band_count()
+{
+    return m_band_count;
+}
+
+uint8_t Fixed8MultiResFFT::get_band(uint16_t band)
+{
+    if (m_bands == nullptr || band >= m_band_count)
+        return 0;
+
+    return m_bands[band];
+}
+
+/**
+ * @brief Returns the center frequency of the band in the merged view
+ *
+ * @param band
+ * @return uint16_t Hz
+ */
+uint16_t Fixed8MultiResFFT::get_band_frequency(uint16_t band)
+{
+    if (m_bands == nullptr)
+        return 0;
+
+    if (band < m_sample_size / 2)
+        return (uint32_t) band * (m_sampling_frequency >> m_decimation_shift) / m_sample_size;
+
+    band = band - m_sample_size / 2 + m_crossover_bin;
+    return (uint32_t) band * m_sampling_frequency / m_short_size;
+}
+
+/**
+ * @brief Stores the sample to the short window & the decimated long window
+ *
+ * @param data
+ * @param sample
+ */
+__attribute__((always_inline)) static inline void store_multires_sample(adc_multires_sample_interrupt *data, int8_t sample)
+{
+    accumulate_adc_level(data->level, sample);
+
+    if (data->short_pos < data->short_size)
+    {
+        data->short_data[data->short_pos] = sample;
+        data->short_pos += 1;
+
+        if (data->short_pos >= data->short_size)
+        {
+            fft_window_complete = 1;
+            fft_window_filling &= ~fft_primary_window;
+            event_bus.post(event_window_ready, 0);
+        }
+    }
+
+    if (data->long_pos >= data->long_size)
+        return;
+
+    /* Decimate by averaging 2^decimation_shift samples */
+    data->long_accumulator += sample;
+    data->decimation_pos += 1;
+
+    if (data->decimation_pos < (1 << data->decimation_shift))
+        return;
+
+    data->long_data[data->long_pos] = data->long_accumulator >> data->decimation_shift;
+    data->long_pos += 1;
+
+    if (data->long_pos >= data->long_size)
+    {
+        fft_window_complete = 1;
+        fft_window_filling &= ~fft_long_window;
+        event_bus.post(event_window_ready, 1);
+    }
+
+    data->long_accumulator = 0;
+    data->decimation_pos = 0;
+}
+
+void Fixed8MultiResFFT::read_audio_source()
+{
+    int8_t samples[16];
+
+    while (interrupt_data.short_pos < m_short_size && interrupt_data.long_pos < m_sample_size)
+    {
+        uint16_t count = m_short_size - interrupt_data.short_pos;
+
+        if (count > sizeof(samples))
+            count = sizeof(samples);
+
+        count = m_audio_source->read(samples, count);
+
+        if (count == 0)
+            break;
+
+        for (uint16_t i = 0; i < count; i++)
+            store_multires_sample(&interrupt_data, samples[i]);
+    }
+}
+
+void Fixed8MultiResFFT::set_audio_source(audio_source *source)
+{
+    m_audio_source = source;
+
+    /* Sources produce full scale int8_t samples. Equals to scale_x of 16 */
+    if (source != nullptr)
+    {
+        interrupt_data.scale_x = 16;
+
+        /* Sampling isr doesn't block on led output anymore */
+        fft_window_filling = 0;
+    }
+}
+
+__attribute__((signal)) void __vector_timer1_compb_adc_read_multires()
+{
+    adc_multires_sample_interrupt *data = (struct adc_multires_sample_interrupt *) get_isr_data_ptr(TIMER1_COMPB_ptr);
+    int8_t sample;
+
+    /* Check if both arrays are filled with data */
+    if (data->short_pos >= data->short_size && data->long_pos >= data->long_size)
+        return;
+
+    count_late_sample();
+
+    if (data->fast_adc)
+        sample = adc_read_fast_sample(data->adc_pin);
+    else
+        sample = adc_read_scaled_sample(data->adc_pin, data->offset_x, data->scale_x);
+
+    store_multires_sample(data, sample);
+    return;
+}
+
+bool Fixed8MultiResFFT::read_level(uint16_t &peak, uint16_t &rms)
+{
+    return read_adc_level(interrupt_data.level, interrupt_data.scale_x, peak, rms);
+}
+
+vector_t Fixed8MultiResFFT::get_read_vector()
+{
+    return __vector_timer1_compb_adc_read_multires;
+}
+
+void *Fixed8MultiResFFT::get_read_vector_data_pointer()
+{
+    return (void *) &interrupt_data;
+}
+
+Fixed8MultiResFFT::~Fixed8MultiResFFT()
+{
+    if (m_adc_mode != adc_10bit)
+        set_adc_mode(adc_10bit);
+
+    deallocate_data_array();
+    return;
+}
@@ -0,0 +1,134 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Mikko Johannes Heinänen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _FIXED_8_MULTIRES_FFT_H_
+#define _FIXED_8_MULTIRES_FFT_H_
+
+#include <inttypes.h>
+#include "Fixed8FFT.h"
+
+/**
+ * @brief Isr for sampling both windows of the multi resolution fft using timer1 compb interrupt
+ *
+ */
+extern void __vector_timer1_compb_adc_read_multires();
+
+/**
+ * @brief Multi resolution adc read interrupt data structure
+ *
+ */
+struct adc_multires_sample_interrupt
+{
+    struct
+    {
+        volatile uint32_t adc_pin : 4;          // Adc input pin
+        volatile uint32_t decimation_shift : 3; // long window is decimated by 2^decimation_shift
+        volatile uint32_t decimation_pos : 8;   // samples summed in long_accumulator
+
+        /* Values to scale the input data */
+        volatile uint32_t offset_x : 7;
+        volatile uint32_t scale_x : 5;
+
+        volatile uint32_t fast_adc : 1;  // adc_8bit_fast mode
+    };
+
+    volatile uint16_t long_size;
+    volatile uint16_t long_pos;
+    volatile uint16_t short_size;
+    volatile uint16_t short_pos;
+    volatile int16_t long_accumulator;
+
+    /* pointers to int8_t arrays */
+    int8_t *volatile long_data;
+    int8_t *volatile short_data;
+
+    /* Signal level of the samples */
+    adc_level_accumulator level;
+};
+
+/**
+ * @brief Concrete strategy class for multi resolution 8bit fft.
+ *      Runs two ffts from the same sample stream:
+ *          - long window decimated by 2^decimation_shift for the bass
+ *          - short window at full sampling frequency for the highs
+ *      Magnitudes are merged into one band energy view where the long window
+ *      covers bands up to its nyquist frequency and the short window the rest.
+ *
+ *      example: sample_size 64, short_window_shift 1, decimation_shift 2, frequency 3200 Hz
+ *          - long:  64 samples at 800 Hz. 12.5 Hz bands up to 400 Hz. New result every 80 ms
+ *          - short: 32 samples at 3200 Hz. 100 Hz bands from 400 Hz to 1600 Hz. New result every 10 ms
+ */
+class Fixed8MultiResFFT : public FFT_backend_template
+{
+private:
+    adc_multires_sample_interrupt interrupt_data;
+    int8_t *m_short_data = nullptr;
+    uint8_t *m_bands = nullptr;
+
+    uint16_t m_short_size = 0;
+    uint16_t m_band_count = 0;
+    uint16_t m_crossover_bin = 0;
+    uint8_t m_short_window_shift;
+    uint8_t m_decimation_shift;
+    uint32_t last_scaling_time = 0;
+
+    void calculate_scaling();
+    void update_sizes(uint16_t sample_size);
+    void clear_sizes();
+
+    /**
+     * @brief Reads samples from the audio source until one of the windows is full
+     *
+     */
+    void read_audio_source();
+
+protected:
+    bool allocate_data_array() override;
+    void deallocate_data_array() override;
+
+public:
+    /**
+     * @brief Construct a new Fixed8MultiResFFT object
+     *
+     * @param input_pin adc pin
+     * @param sample_size long window size. Power of two
+     * @param short_window_shift short window size is sample_size >> short_window_shift
+     * @param decimation_shift long window is decimated by 2^decimation_shift
+     * @param mode adc sampling mode
+     */
+    Fixed8MultiResFFT(uint8_t input_pin, uint16_t sample_size, uint8_t short_window_shift, uint8_t decimation_shift, adc_mode mode = adc_10bit);
+    uint16_t calculate() override;
+
+    bool set_sample_size(uint16_t sample_size) override;
+    bool read_level(uint16_t &peak, uint16_t &rms) override;
+    void set_audio_source(audio_source *source) override;
+    vector_t get_read_vector() override;
+    void *get_read_vector_data_pointer() override;
+
+    uint16_t get_band_count() override;
+    uint8_t get_band(uint16_t band) override;
+    uint16_t get_band_frequency(uint16_t band) override;
+    ~Fixed8MultiResFFT();
+};
+#endif
@@ -3,6 +3,9 @@
 
 #define ENABLE_ISR_VECTOR_DATA_POINTER_TABLE_SIZE 1
 
+/* SubEffects' config. CONF_ENABLE_FRAME_CLOCK selects TIMER1_COMPA */
+#include "../../../config.h"
+
 /* Config file to select wich interrupt vectors are binded at runtime */
 /* Uncomment to enable runtime binding for the interrupt */
 
@@ -26,7 +29,9 @@
 //
 // #define TIMER1_CAPT_used
 //
-// #define TIMER1_COMPA_used
+#if CONF_ENABLE_FRAME_CLOCK == 1
+#define TIMER1_COMPA_used
+#endif
 //
 #define TIMER1_COMPB_used
 //
@@ -133,7 +138,9 @@
 //
 // #define TIMER1_CAPT_data
 //
-// #define TIMER1_COMPA_data
+#if CONF_ENABLE_FRAME_CLOCK == 1
+#define TIMER1_COMPA_data
+#endif
 //
 #define TIMER1_COMPB_data
 //
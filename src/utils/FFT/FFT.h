@@ -27,9 +27,12 @@
 #include <inttypes.h>
 #include "../../config.h"
 #include "../debug.h"
+#include "../colorMath.h"
+#include "../profiler.h"
 #include "../arch/avr/atmega328p/timer1.h"
 #include "FFT_strategy.h"
 #include "../../lib/Fixed8FFT/Fixed8FFT.h"
+#include "../../lib/Fixed8FFT/Fixed8MultiResFFT.h"
 
 class FFT
 {
@@ -37,30 +40,52 @@ private:
     FFT_backend_template *fft = nullptr;
     static timer1 timer;
 
-public:
-    FFT(uint8_t input_pin, uint16_t sample_size, uint16_t frequency, fft_backend backend = fixed_8)
+    envelope_follower peak_envelope = envelope_follower(AUDIO_ENVELOPE_ATTACK_MS, AUDIO_ENVELOPE_RELEASE_MS);
+    envelope_follower rms_envelope = envelope_follower(AUDIO_ENVELOPE_ATTACK_MS, AUDIO_ENVELOPE_RELEASE_MS);
+
+    /* millis() of the last envelope step by update_envelope() */
+    uint32_t last_envelope_time = 0;
+
+    /* 1 when the backend's isr is bound to timer1 compb */
+    bool isr_bound = 0;
+
+    /* Window is full_sample_size >> quality_shift. See set_quality_shift() */
+    uint16_t full_sample_size = 0;
+    uint8_t quality_shift = 0;
+
+    /**
+     * @brief Creates the fft backend
+     *
+     * @return true on failure
+     * @return false backend created
+     */
+    bool create_backend(uint8_t input_pin, uint16_t sample_size, uint16_t frequency, fft_backend backend, adc_mode mode)
     {
         switch (backend)
         {
         case fixed_8:
-            fft = new Fixed8FFT(input_pin, sample_size, frequency, backend);
+            fft = new Fixed8FFT(input_pin, sample_size, frequency, backend, mode);
+            break;
+
+        case fixed_8_multires:
+            fft = new Fixed8MultiResFFT(input_pin, sample_size, MULTIRES_SHORT_WINDOW_SHIFT, MULTIRES_DECIMATION_SHIFT, mode);
             break;
 
         default:
             ERROR(F("Invalid backend number"));
-            return;
+            return 1;
 
         #ifdef DEBUG_CHECKS
-            if (backend > fixed_8)
+            if (backend > fixed_8_multires)
                 ERROR(F("Bits number: "), backend, F(" isnt't implemented"));
         #endif
-            return;
+            return 1;
         }
 
         if (fft == nullptr)
         {
             ERROR(F("Not enough memory for fft backend: "), backend);
-            return;
+            return 1;
         }
 
         /**
@@ -70,9 +95,30 @@ public:
         if (fft->get_sample_size() != sample_size)
         {
             ERROR(F("FFT: fft backend doesn't support sample size: "), sample_size);
-            goto delete_ptr_and_fail;
+            delete fft;
+            fft = nullptr;
+            return 1;
         }
 
+        return 0;
+    }
+
+public:
+    /**
+     * @brief Construct a new FFT object & start sampling
+     *      Samples are read by the timer1 compb adc isr
+     *
+     * @param input_pin adc pin
+     * @param sample_size fft window size. Power of two
+     * @param frequency sampling frequency in Hz
+     * @param backend fft backend
+     * @param mode adc sampling mode. See adc_mode
+     */
+    FFT(uint8_t input_pin, uint16_t sample_size, uint16_t frequency, fft_backend backend = fixed_8, adc_mode mode = adc_10bit)
+    {
+        if (create_backend(input_pin, sample_size, frequency, backend, mode))
+            return;
+
         if (fft->get_read_vector() == nullptr)
         {
             INFO(F("FFT: fft backend doesn't have read isr"));
@@ -120,6 +166,7 @@ public:
         cli();
         bind_isr(TIMER1_COMPB_, fft->get_read_vector());
         fft->m_sampling_frequency = timer.Start(frequency);
+        isr_bound = 1;
         sei();
 
         #ifdef DEBUG_CHECKS
@@ -140,13 +187,32 @@ public:
         return;
     }
 
+    /**
+     * @brief Construct a new FFT object which reads its samples from the audio source.
+     *      Doesn't use the adc, timer1 or the sampling isr.
+     *      Samples are pulled from the source on calculate() until a window is full.
+     *
+     * @param source audio source. Has to outlive the FFT object
+     * @param sample_size fft window size. Power of two
+     * @param frequency sample rate of the source in Hz
+     * @param backend fft backend
+     */
+    FFT(audio_source &source, uint16_t sample_size, uint16_t frequency, fft_backend backend = fixed_8)
+    {
+        if (create_backend(0, sample_size, frequency, backend, adc_10bit))
+            return;
+
+        fft->m_sampling_frequency = frequency;
+        fft->set_audio_source(&source);
+    }
+
     ~FFT()
     {
         if (fft == nullptr)
             return;
 
         cli();
-        if (fft->get_read_vector() != nullptr && fft->get_read_vector() == get_isr_vector(TIMER1_COMPB_))
+        if (isr_bound && fft->get_read_vector() != nullptr && fft->get_read_vector() == get_isr_vector(TIMER1_COMPB_))
         {
             /* Check if fft objects data ptr is used */
             if (fft->get_read_vector_data_pointer() != nullptr && fft->get_read_vector_data_pointer() == get_isr_data_ptr(TIMER1_COMPB_ptr))
@@ -171,7 +237,168 @@ public:
             return 0;
         }
 
+#if CONF_ENABLE_PROFILER == 1
+        PROFILE_START(fft_start);
+        uint16_t ret = fft->calculate();
+        PROFILE_END(profiler.fft, fft_start);
+        return ret;
+#else
         return fft->calculate();
+#endif
+    }
+
+    /**
+     * @brief Updates the loudness envelopes from the samples
+     *      the sampling isr has captured since the last call.
+     *      Doesn't touch the adc.
+     *
+     * @return true envelopes were updated
+     * @return false no new samples
+     */
+    bool update_envelope()
+    {
+        uint32_t now = millis();
+
+        if (!update_envelope(now - last_envelope_time))
+            return 0;
+
+        last_envelope_time = now;
+        return 1;
+    }
+
+    /**
+     * @brief update_envelope() with the time delta from the caller. e.g. frame_context
+     *
+     * @param time_delta_ms time since the previous call
+     * @return true envelopes were updated
+     * @return false no new samples
+     */
+    bool update_envelope(uint32_t time_delta_ms)
+    {
+        uint16_t peak = 0;
+        uint16_t rms = 0;
+
+        if (fft == nullptr)
+            return 0;
+
+        if (!fft->read_level(peak, rms))
+            return 0;
+
+        peak_envelope.calc(peak, time_delta_ms);
+        rms_envelope.calc(rms, time_delta_ms);
+        return 1;
+    }
+
+    /**
+     * @brief Get the peak envelope
+     *
+     * @return uint16_t half of the peak to peak amplitude in adc units
+     */
+    uint16_t get_peak_envelope() { return peak_envelope.get(); }
+
+    /**
+     * @brief Get the rms envelope
+     *
+     * @return uint16_t rms amplitude in adc units
+     */
+    uint16_t get_rms_envelope() { return rms_envelope.get(); }
+
+    /**
+     * @brief Get the number of bands in the backend's band energy view
+     *
+     * @return uint16_t 0 if backend doesn't provide band energies
+     */
+    uint16_t get_band_count()
+    {
+        if (fft == nullptr)
+            return 0;
+
+        return fft->get_band_count();
+    }
+
+    /**
+     * @brief Get the magnitude of a band from the latest windows
+     *
+     * @param band
+     * @return uint8_t 0 - 127
+     */
+    uint8_t get_band(uint16_t band)
+    {
+        if (fft == nullptr)
+            return 0;
+
+        return fft->get_band(band);
+    }
+
+    /**
+     * @brief Get the center frequency of the band
+     *
+     * @param band
+     * @return uint16_t Hz
+     */
+    uint16_t get_band_frequency(uint16_t band)
+    {
+        if (fft == nullptr)
+            return 0;
+
+        return fft->get_band_frequency(band);
+    }
+
+    /**
+     * @brief Get the window size
+     *
+     * @return uint16_t 0 if no backend
+     */
+    uint16_t get_sample_size()
+    {
+        if (fft == nullptr)
+            return 0;
+
+        return fft->get_sample_size();
+    }
+
+    /**
+     * @brief Shrinks the window to 1 / 2^shift of its full size. 
+     *      Halves the fft's cost per step at the expense of frequency resolution.
+     *      Used by led_manager's quality governor
+     *
+     * @param shift 0 restores the full window
+     * @return true backend doesn't support the size. Window is unchanged
+     * @return false 
+     */
+    bool set_quality_shift(uint8_t shift)
+    {
+        if (fft == nullptr)
+            return 1;
+
+        if (shift == quality_shift)
+            return 0;
+
+        if (quality_shift == 0)
+            full_sample_size = fft->get_sample_size();
+
+        if (fft->set_sample_size(full_sample_size >> shift))
+            return 1;
+
+        quality_shift = shift;
+        return 0;
+    }
+
+    /**
+     * @brief Set the object which receives the magnitude bins of every window
+     *      e.g. spectrogram_history
+     *
+     * @param sink nullptr to disable
+     */
+    void set_spectrum_sink(spectrum_sink *sink)
+    {
+        if (fft == nullptr)
+        {
+            ERROR(F("FFT: No FFT backend initialized"));
+            return;
+        }
+
+        fft->set_spectrum_sink(sink);
     }
 };
 
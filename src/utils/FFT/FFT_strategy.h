@@ -25,6 +25,8 @@
 #define _FFT_STRATEGY_H_
 
 #include "../../lib/rISR/src/rISR.h"
+#include "audio_source.h"
+#include "../event_queue.h"
 
 /**
  * @brief Enum for implemented backends
@@ -33,8 +35,88 @@
 typedef enum
 {
     fixed_8,
+    fixed_8_multires,
 } fft_backend;
 
+/**
+ * @brief Adc sampling modes of the sampling isr
+ *
+ *  adc_10bit:
+ *      Arduino's default adc prescaler of 128 (125 kHz adc clock).
+ *      Conversion takes 13 adc clocks, 104 us by the datasheet, which the isr busy waits.
+ *      10 bit result is auto ranged into int8_t with offset & scale values.
+ *
+ *  adc_8bit_fast:
+ *      Adc prescaler 16 (1 MHz adc clock) & left adjusted result (ADLAR).
+ *      Only ADCH is read. Conversion takes 13 adc clocks, 13 us by the datasheet,
+ *      so the isr is about 8x shorter and sampling frequencies up to ~20 kHz become usable.
+ *      The datasheet specifies full 10 bit accuracy only up to 200 kHz adc clock
+ *      & gives no figure for 1 MHz. The extra error is assumed to land mostly in
+ *      the 2 dropped LSBs, so the 8 bit result should stay within a few LSB.
+ *      These are estimates from the datasheet, noise & timing haven't been measured.
+ *      There is no auto ranging. Full adc range maps to int8_t, so quiet signals
+ *      use less of the fft's dynamic range than in adc_10bit mode.
+ *
+ * @note adc_8bit_fast changes the adc prescaler globally while the fft exists.
+ *       analogRead() keeps working, but with the reduced accuracy.
+ */
+typedef enum
+{
+    adc_10bit,
+    adc_8bit_fast,
+} adc_mode;
+
+/**
+ * @brief Set by the sampling isr when a window is filled & ready for calculate().
+ *      Lets the led manager's idle sleep wake up for it. Cleared by the reader.
+ *      The isr also posts event_window_ready to event_bus
+ */
+extern volatile bool fft_window_complete;
+
+/**
+ * @brief Windows of fft_window_filling & fft_window_corrupted
+ *
+ */
+typedef enum
+{
+    fft_primary_window = 1,     // Fixed8FFT's window, Fixed8MultiResFFT's short window
+    fft_long_window = 2,        // Fixed8MultiResFFT's decimated long window
+} fft_window_t;
+
+/**
+ * @brief Sampling status shared by the sampling isr, the fft backend & the led manager.
+ *      fft_window_filling: fft_window_t bits of the windows the sampling isr is filling. 
+ *          Set by the backend when it restarts a window, cleared by the isr once the window is full.
+ *      fft_window_corrupted: fft_window_t bits of the windows which lost samples to led output.
+ *          Set only when discarding is enabled, see led_manager::set_discard_corrupted_windows().
+ *          The backend samples those windows again instead of calculating them.
+ *      fft_window_samples: raw samples in the primary window. Sets the sampler sync timeout
+ *      fft_late_samples: samples taken over half a sample period late. See CONF_SAMPLER_STATS
+ */
+extern volatile uint8_t fft_window_filling;
+extern volatile uint8_t fft_window_corrupted;
+extern uint16_t fft_window_samples;
+extern volatile uint16_t fft_late_samples;
+
+/**
+ * @brief Interface for objects that want the fft's magnitude bins.
+ *      The backend calls push_spectrum() after every calculated window,
+ *      before the sample buffer is given back to the sampling isr.
+ */
+class spectrum_sink
+{
+public:
+    /**
+     * @brief Receives the magnitude bins of the latest window
+     *
+     * @param bins magnitude of each bin. 0 - 127. bins[0] is the dc bin
+     * @param bin_count number of bins. Half of the sample size
+     */
+    virtual void push_spectrum(const uint8_t *bins, uint16_t bin_count) = 0;
+
+    virtual ~spectrum_sink() = default;
+};
+
 /**
  * @brief FFT abstraction layer
  *
@@ -44,6 +126,9 @@ class FFT_backend_template
 protected:
     uint16_t m_sample_size;
     void *m_data = nullptr;
+    spectrum_sink *m_spectrum_sink = nullptr;
+    adc_mode m_adc_mode = adc_10bit;
+    audio_source *m_audio_source = nullptr;
 
     /**
      * @brief Allocates array of custom data size * sample size. Then sets data to point to it
@@ -80,6 +165,28 @@ public:
      */
     uint16_t get_sample_size() { return m_sample_size; }
 
+    /**
+     * @brief Get the adc sampling mode
+     *
+     * @return adc_mode
+     */
+    adc_mode get_adc_mode() { return m_adc_mode; }
+
+    /**
+     * @brief Set the audio source which is pulled on calculate()
+     *      instead of using the sampling isr
+     *
+     * @param source nullptr to use the sampling isr
+     */
+    virtual void set_audio_source(audio_source *source) { m_audio_source = source; }
+
+    /**
+     * @brief Set the object which receives the magnitude bins of every window
+     *
+     * @param sink nullptr to disable
+     */
+    void set_spectrum_sink(spectrum_sink *sink) { m_spectrum_sink = sink; }
+
     /**
      * @brief Calculates fft & returns the loudest hz.
      *
@@ -87,6 +194,39 @@ public:
      */
     virtual uint16_t calculate() = 0;
 
+    /**
+     * @brief Reads the signal level of the samples captured since the last call
+     *
+     * @param peak half of the peak to peak amplitude in adc units
+     * @param rms rms amplitude without dc in adc units
+     * @return true new samples were available
+     * @return false no samples since the last call or backend doesn't track levels
+     */
+    virtual bool read_level(uint16_t &peak, uint16_t &rms) { return 0; }
+
+    /**
+     * @brief Get the number of bands in the backend's band energy view
+     *
+     * @return uint16_t 0 if backend doesn't provide band energies
+     */
+    virtual uint16_t get_band_count() { return 0; }
+
+    /**
+     * @brief Get the magnitude of a band from the latest windows
+     *
+     * @param band
+     * @return uint8_t 0 - 127
+     */
+    virtual uint8_t get_band(uint16_t band) { return 0; }
+
+    /**
+     * @brief Get the center frequency of the band
+     *
+     * @param band
+     * @return uint16_t Hz
+     */
+    virtual uint16_t get_band_frequency(uint16_t band) { return 0; }
+
     /**
      * @brief Gets the fft implementation specific sampling interrupt vector address.
      *
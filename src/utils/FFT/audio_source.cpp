@@ -0,0 +1,130 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Mikko Johannes Heinänen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "audio_source.h"
+
+bool synthetic_audio_source::add_tone(uint16_t frequency, uint8_t amplitude)
+{
+    if (m_tone_count >= SYNTHETIC_SOURCE_MAX_TONES)
+    {
+        ERROR(F("synthetic_audio_source: max tones: "), SYNTHETIC_SOURCE_MAX_TONES);
+        return 1;
+    }
+
+    m_tones[m_tone_count].phase = 0;
+    m_tones[m_tone_count].phase_step = ((uint32_t) frequency << 16) / m_sample_rate;
+    m_tones[m_tone_count].amplitude = amplitude;
+    m_tone_count++;
+    return 0;
+}
+
+void synthetic_audio_source::set_noise(uint8_t amplitude)
+{
+    m_noise_amplitude = amplitude;
+}
+
+void synthetic_audio_source::set_kick(uint16_t interval_ms, uint8_t amplitude, uint16_t frequency)
+{
+    m_kick_interval = (uint32_t) interval_ms * m_sample_rate / 1000;
+    m_kick.amplitude = amplitude;
+    m_kick.phase_step = ((uint32_t) frequency << 16) / m_sample_rate;
+    m_kick_counter = 0;
+}
+
+void synthetic_audio_source::reset()
+{
+    for (uint8_t i = 0; i < m_tone_count; i++)
+        m_tones[i].phase = 0;
+
+    m_lfsr = 0xACE1;
+    m_kick.phase = 0;
+    m_kick_counter = 0;
+    m_kick_envelope = 0;
+}
+
+uint16_t synthetic_audio_source::read(int8_t *buffer, uint16_t count)
+{
+    for (uint16_t i = 0; i < count; i++)
+    {
+        int16_t sample = 0;
+
+        for (uint8_t j = 0; j < m_tone_count; j++)
+            sample += sine_sample(m_tones[j]);
+
+        if (m_noise_amplitude)
+        {
+            /* 16 bit galois lfsr */
+            m_lfsr = (m_lfsr >> 1) ^ (-(m_lfsr & 1) & 0xB400u);
+            sample += ((int16_t) (int8_t) m_lfsr * m_noise_amplitude) >> 7;
+        }
+
+        if (m_kick_interval)
+        {
+            if (m_kick_counter == 0)
+            {
+                m_kick_envelope = 0xff00;
+                m_kick.phase = 0;
+                m_kick_counter = m_kick_interval;
+            }
+            m_kick_counter--;
+
+            /* ~32 sample decay time constant */
+            m_kick_envelope -= m_kick_envelope >> 5;
+            sample += (sine_sample(m_kick) * (m_kick_envelope >> 8)) >> 8;
+        }
+
+        buffer[i] = constrain(sample, -128, 127);
+    }
+
+    return count;
+}
+
+uint16_t buffer_audio_source::read(int8_t *buffer, uint16_t count)
+{
+    uint16_t written = 0;
+
+    if (m_buffer == nullptr || m_size == 0)
+        return 0;
+
+    while (written < count)
+    {
+        if (m_pos >= m_size)
+        {
+            if (!m_loop)
+                break;
+
+            m_pos = 0;
+        }
+
+        if (m_progmem)
+            buffer[written] = (int8_t) pgm_read_byte(&m_buffer[m_pos]);
+        else
+            buffer[written] = m_buffer[m_pos];
+
+        m_pos++;
+        written++;
+    }
+
+    return written;
+}
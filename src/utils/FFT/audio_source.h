@@ -0,0 +1,163 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Mikko Johannes Heinänen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef _AUDIO_SOURCE_H_
+#define _AUDIO_SOURCE_H_
+
+#include <inttypes.h>
+#include <FastLED.h>
+#include "../../config.h"
+#include "../debug.h"
+
+/**
+ * @brief Audio source abstraction layer.
+ *      Sources are pulled by the fft backend from FFT::calculate()
+ *      instead of the timer1 compb adc sampling isr. This makes it possible to
+ *      run the whole analysis chain without the adc or the timer.
+ *
+ * @note The timer1 adc isr stays the default source. It is used when the FFT
+ *       is constructed with an input pin.
+ */
+class audio_source
+{
+public:
+    /**
+     * @brief Writes up to count samples to the buffer
+     *
+     * @param buffer
+     * @param count
+     * @return uint16_t number of samples written
+     */
+    virtual uint16_t read(int8_t *buffer, uint16_t count) = 0;
+
+    virtual ~audio_source() = default;
+};
+
+/**
+ * @brief Deterministic test signal generator.
+ *      Mixes sine tones, pseudo random noise & periodic decaying kicks.
+ *      Same settings always produce the same samples.
+ */
+class synthetic_audio_source : public audio_source
+{
+private:
+    struct tone
+    {
+        uint16_t phase = 0;
+        uint16_t phase_step = 0;
+        uint8_t amplitude = 0;
+    };
+
+    tone m_tones[SYNTHETIC_SOURCE_MAX_TONES];
+    uint8_t m_tone_count = 0;
+    uint16_t m_sample_rate;
+
+    uint16_t m_lfsr = 0xACE1;
+    uint8_t m_noise_amplitude = 0;
+
+    tone m_kick;
+    uint16_t m_kick_interval = 0;
+    uint16_t m_kick_counter = 0;
+    uint16_t m_kick_envelope = 0; // Q8
+
+    __attribute__((always_inline)) inline int8_t sine_sample(tone &t)
+    {
+        int16_t value = (int16_t) sin8(t.phase >> 8) - 128;
+
+        t.phase += t.phase_step;
+        return (value * t.amplitude) >> 7;
+    }
+
+public:
+    synthetic_audio_source(uint16_t sample_rate) : m_sample_rate(sample_rate) {}
+
+    /**
+     * @brief Adds sine tone to the mix
+     *
+     * @param frequency Hz
+     * @param amplitude 0 - 127
+     * @return true if no room for more tones
+     * @return false tone added
+     */
+    bool add_tone(uint16_t frequency, uint8_t amplitude);
+
+    /**
+     * @brief Set the pseudo random noise level
+     *
+     * @param amplitude 0 - 127
+     */
+    void set_noise(uint8_t amplitude);
+
+    /**
+     * @brief Adds a decaying low frequency burst every interval_ms
+     *
+     * @param interval_ms 0 to disable
+     * @param amplitude 0 - 127
+     * @param frequency Hz of the kick
+     */
+    void set_kick(uint16_t interval_ms, uint8_t amplitude, uint16_t frequency = 55);
+
+    /**
+     * @brief Restarts the signal from the beginning
+     *
+     */
+    void reset();
+
+    uint16_t read(int8_t *buffer, uint16_t count) override;
+};
+
+/**
+ * @brief Replays recorded samples from a buffer in ram or in progmem
+ *
+ */
+class buffer_audio_source : public audio_source
+{
+private:
+    const int8_t *m_buffer;
+    uint16_t m_size;
+    uint16_t m_pos = 0;
+    bool m_loop;
+    bool m_progmem;
+
+public:
+    /**
+     * @brief Construct a new buffer audio source object
+     *
+     * @param buffer recorded samples
+     * @param size number of samples
+     * @param loop 1 to start from the beginning when the end is reached
+     * @param progmem 1 if the buffer is stored in PROGMEM
+     */
+    buffer_audio_source(const int8_t *buffer, uint16_t size, bool loop = true, bool progmem = false)
+        : m_buffer(buffer), m_size(size), m_loop(loop), m_progmem(progmem) {}
+
+    /**
+     * @brief Restarts the replay from the beginning
+     *
+     */
+    void reset() { m_pos = 0; }
+
+    uint16_t read(int8_t *buffer, uint16_t count) override;
+};
+
+#endif
@@ -0,0 +1,201 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Mikko Johannes Heinänen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#ifndef _SPECTROGRAM_HISTORY_H_
+#define _SPECTROGRAM_HISTORY_H_
+
+#include <inttypes.h>
+#include "../../config.h"
+#include "../debug.h"
+#include "../data_types/ringbuffer.h"
+#include "FFT_strategy.h"
+
+/**
+ * @brief Single quantised spectrum.
+ *      Band values are stored with 4 or 8 bits. 4 bit bands are packed two per byte.
+ *
+ * @tparam BANDS number of frequency bands
+ * @tparam BITS 4 or 8
+ */
+template <uint8_t BANDS, uint8_t BITS>
+struct spectrogram_frame
+{
+    static_assert(BITS == 4 || BITS == 8, "spectrogram_frame: only 4 and 8 bit quantisation is supported");
+
+    uint8_t data[(BANDS * BITS + 7) / 8];
+
+    /**
+     * @brief Returns the band's value scaled back to 0 - 255
+     *
+     * @param band
+     * @return uint8_t
+     */
+    __attribute__((always_inline)) inline uint8_t get(uint8_t band) const
+    {
+        if (BITS == 8)
+            return data[band];
+
+        if (band & 1)
+            return (data[band >> 1] >> 4) * 17;
+
+        return (data[band >> 1] & 0x0f) * 17;
+    }
+
+    /**
+     * @brief Quantises 0 - 255 value into the band
+     *
+     * @param band
+     * @param value
+     */
+    __attribute__((always_inline)) inline void set(uint8_t band, uint8_t value)
+    {
+        if (BITS == 8)
+        {
+            data[band] = value;
+            return;
+        }
+
+        uint8_t &packed = data[band >> 1];
+        value >>= 4;
+
+        if (band & 1)
+            packed = (packed & 0x0f) | (value << 4);
+        else
+            packed = (packed & 0xf0) | value;
+    }
+};
+
+/**
+ * @brief Keeps the last FRAMES spectra of the fft as band energies.
+ *      Bind it to an fft with FFT::set_spectrum_sink().
+ *
+ *      Memory usage: FRAMES * BANDS * BITS / 8 bytes
+ *      e.g. 32 frames of 16 bands with 4 bit quantisation takes 256 bytes.
+ *
+ * @tparam BANDS number of frequency bands. fft bins are grouped evenly into the bands
+ * @tparam FRAMES number of spectra kept
+ * @tparam BITS 4 or 8 bit quantisation
+ */
+template <uint8_t BANDS, uint8_t FRAMES, uint8_t BITS = 4>
+class spectrogram_history : public spectrum_sink
+{
+public:
+    typedef spectrogram_frame<BANDS, BITS> frame_t;
+
+private:
+    frame_t frames[FRAMES];
+    ringbuffer<frame_t> history = ringbuffer<frame_t>(frames, FRAMES);
+    uint8_t frame_count = 0;
+
+public:
+    spectrogram_history() = default;
+    ~spectrogram_history() = default;
+
+    /* history points into this object's frames. A copy would share them */
+    spectrogram_history(const spectrogram_history &) = delete;
+    spectrogram_history &operator=(const spectrogram_history &) = delete;
+
+    /**
+     * @brief Groups the bins into bands and stores them as the newest frame.
+     *      The dc bin is skipped. Each band holds the loudest bin of its group.
+     *
+     * @param bins magnitude bins. 0 - 127
+     * @param bin_count
+     */
+    void push_spectrum(const uint8_t *bins, uint16_t bin_count) override
+    {
+        frame_t frame = {};
+        uint16_t bins_per_band;
+        uint16_t bin = 1;
+
+        if (bin_count < 2)
+            return;
+
+        bins_per_band = (bin_count - 1) / BANDS;
+        if (bins_per_band == 0)
+            bins_per_band = 1;
+
+        for (uint8_t band = 0; band < BANDS; band++)
+        {
+            uint8_t loudest = 0;
+
+            for (uint16_t i = 0; i < bins_per_band && bin < bin_count; i++, bin++)
+            {
+                if (bins[bin] > loudest)
+                    loudest = bins[bin];
+            }
+
+            /* 0 - 127 magnitude to 0 - 255 */
+            frame.set(band, loudest << 1);
+        }
+
+        history.push(frame);
+
+        if (frame_count < FRAMES)
+            frame_count++;
+    }
+
+    /**
+     * @brief Returns the stored frame without copying it
+     *
+     * @param age 0 for the newest frame. Has to be smaller than get_frame_count()
+     * @return const frame_t&
+     */
+    const frame_t &get_frame(uint8_t age)
+    {
+        return history.peek(age);
+    }
+
+    /**
+     * @brief Returns single band's value from the stored frame
+     *
+     * @param age 0 for the newest frame
+     * @param band
+     * @return uint8_t 0 - 255
+     */
+    uint8_t get(uint8_t age, uint8_t band)
+    {
+        if (age >= frame_count || band >= BANDS)
+            return 0;
+
+        return history.peek(age).get(band);
+    }
+
+    /**
+     * @brief Returns the number of frames stored. Max FRAMES
+     *
+     */
+    uint8_t get_frame_count() { return frame_count; }
+
+    /**
+     * @brief Forgets all stored frames
+     *
+     */
+    void clear()
+    {
+        history.resize(frames, FRAMES);
+        frame_count = 0;
+    }
+};
+
+#endif
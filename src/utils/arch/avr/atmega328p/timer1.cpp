@@ -110,6 +110,33 @@ inline void timer1::Continue()
     return;
 }
 
+/**
+ * @brief Returns 1 when the timer has a clock source & isn't powered down
+ *
+ */
+bool timer1::IsRunning()
+{
+    return !(PRR & (1 << PRTIM1)) && (TCCR1B & ((1 << CS10) | (1 << CS11) | (1 << CS12)));
+}
+
+/**
+ * @brief Returns the compare match frequency set by SetTimerFrequency()
+ *
+ * @retval uint32_t: frequency in Hz. 0 when the timer is stopped
+ */
+uint32_t timer1::GetFrequency()
+{
+    const uint16_t prescaler_values[] = {1, 8, 64, 256, 1024};
+    uint8_t clock_select = TCCR1B & ((1 << CS10) | (1 << CS11) | (1 << CS12));
+
+    /* Clock select 6 & 7 are the external clock on T1 */
+    if (!IsRunning() || clock_select > 5 || OCR1A == 0)
+        return 0;
+
+    /* CTC period is OCR1A + 1 timer clocks */
+    return F_CPU / (prescaler_values[clock_select - 1] * (OCR1A + 1UL));
+}
+
 timer1::~timer1()
 {
     TCCR1A = 0;
@@ -50,6 +50,8 @@ public:
     uint32_t Start(uint32_t freq);                  // initializes the timer1's settings | Returns the hz it was able to set
     void Stop();                                    // turns off the timer
     void Continue();                                // Turns the timer back on
+    static bool IsRunning();                        // 1 when clocked & not powered down
+    static uint32_t GetFrequency();                 // Returns the compare match frequency in Hz. 0 when stopped
     ~timer1();                                      // Resets timer1 to it's default values.
 };
 #endif
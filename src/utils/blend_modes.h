@@ -0,0 +1,84 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Mikko Johannes Heinänen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _BLEND_MODES_H_
+#define _BLEND_MODES_H_
+
+#include <FastLED.h>
+#include <inttypes.h>
+
+/**
+ * @brief How a layer is combined with the pixels below it
+ * 
+ */
+typedef enum
+{
+    blend_replace,  /* Layer's pixels replace the ones below. Opaque */
+    blend_add,      /* Saturating add */
+    blend_max,      /* Brighter channel wins */
+    blend_alpha,    /* Mix by the layer's alpha. Opaque when alpha is 255 */
+    blend_multiply  /* Scales the pixels below by the layer's pixels */
+} blend_mode;
+
+/**
+ * @brief Blends src on top of dst
+ * 
+ * @param dst pixel below. Result is written here
+ * @param src layer's pixel
+ * @param mode 
+ * @param alpha used by blend_alpha
+ */
+__attribute__((always_inline)) inline void blend_pixel(CRGB &dst, const CRGB &src, blend_mode mode, uint8_t alpha)
+{
+    switch (mode)
+    {
+    case blend_replace:
+        dst = src;
+        break;
+
+    case blend_add:
+        dst.r = qadd8(dst.r, src.r);
+        dst.g = qadd8(dst.g, src.g);
+        dst.b = qadd8(dst.b, src.b);
+        break;
+
+    case blend_max:
+        if (src.r > dst.r) dst.r = src.r;
+        if (src.g > dst.g) dst.g = src.g;
+        if (src.b > dst.b) dst.b = src.b;
+        break;
+
+    case blend_alpha:
+        nblend(dst, src, alpha);
+        break;
+
+    case blend_multiply:
+        dst.r = scale8(dst.r, src.r);
+        dst.g = scale8(dst.g, src.g);
+        dst.b = scale8(dst.b, src.b);
+        break;
+    }
+}
+
+#endif
@@ -1,19 +1,136 @@
 #include "colorMath.h"
 
-float moving_average_filter::calc(float val)
+const uint8_t gamma8_table[256] PROGMEM = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255
+};
+
+/* exp(-i / 16) in Q16. Entries past the table are below 0.5 */
+const uint16_t exp_table[EXP_TABLE_SIZE] PROGMEM = {
+    65535, 61565, 57835, 54331, 51039, 47947, 45042, 42313, 39750, 37341, 35079, 32954,
+    30957, 29081, 27319, 25664, 24109, 22649, 21276, 19987, 18776, 17639, 16570, 15566,
+    14623, 13737, 12905, 12123, 11388, 10698, 10050,  9441,  8869,  8332,  7827,  7353,
+     6907,  6489,  6096,  5726,  5380,  5054,  4747,  4460,  4190,  3936,  3697,  3473,
+     3263,  3065,  2879,  2705,  2541,  2387,  2243,  2107,  1979,  1859,  1746,  1641,
+     1541,  1448,  1360,  1278,  1200,  1128,  1059,   995,   935,   878,   825,   775,
+      728,   684,   642,   604,   567,   533,   500,   470,   442,   415,   390,   366,
+      344,   323,   303,   285,   268,   252,   236,   222,   209,   196,   184,   173,
+      162,   153,   143,   135,   127,   119,   112,   105,    99,    93,    87,    82,
+       77,    72,    68,    64,    60,    56,    53,    50,    47,    44,    41,    39,
+       36,    34,    32,    30,    28,    27,    25,    23,    22,    21,    19,    18,
+       17,    16,    15,    14,    13,    13,    12,    11,    10,    10,     9,     9,
+        8,     8,     7,     7,     6,     6,     6,     5,     5,     5,     4,     4,
+        4,     4,     3,     3,     3,     3,     3,     2,     2,     2,     2,     2,
+        2,     2,     2,     1,     1,     1,     1,     1,     1,     1,     1,     1,
+        1,     1,     1,     1,     1,     1,     1,     1,     1,     0,     0,     0
+};
+
+/*
+ * The batch loops only use 8 x 8 bit multiplies & walk the arrays with pointers,
+ * which avr-gcc turns into mul & ld/st X+ without 16 bit index math.
+ * Branch free bodies let a host build vectorise them.
+ */
+void decay_array(uint8_t *__restrict__ data, uint16_t count, uint8_t scale)
+{
+    uint8_t *end = data + count;
+
+    for (; data < end; data++)
+        *data = ((uint16_t) *data * scale + *data) >> 8;
+}
+
+void ewma_array(uint8_t *__restrict__ state, const uint8_t *__restrict__ input, uint16_t count, uint8_t alpha)
 {
-    _sampleTotal = _sampleTotal - _window[_curReadIndex]; // subtract the last reading
-    _window[_curReadIndex] = val;                         // add the latest value
-    _sampleTotal += _window[_curReadIndex];               // add the reading to the total
-    _sampleAvg = _sampleTotal / 2.0;                      // calculate the average
-    _curReadIndex += 1;
-    if (_curReadIndex >= 2)
-        _curReadIndex = 0;
-    return _sampleAvg;
+    uint8_t *end = state + count;
+
+    for (; state < end; state++, input++)
+    {
+        uint8_t value = *state;
+        uint8_t target = *input;
+        bool rising = target >= value;
+        uint8_t difference = rising ? target - value : value - target;
+
+        /* Rounded up, so the step is at least 1 until the state reaches the target */
+        uint8_t step = ((uint16_t) difference * alpha + 255) >> 8;
+
+        *state = rising ? value + step : value - step;
+    }
 }
 
 float weighted_moving_average_filter::calc(float analogRead)
 {
     _result = _Alpha * analogRead + (1 - _Alpha) * _result;
     return _result;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Construct a new exp smoother object
+ *
+ * @param window_size same as EWMAtest's window_size. Max 5
+ */
+exp_smoother::exp_smoother(float window_size)
+{
+    /* ln(20) * window_size per 1000 ms, in Q16 of the Q12 exponent */
+    m_rate = 2.9957323F * window_size * 4096.0F * 65536.0F / 1000.0F;
+}
+
+/**
+ * @brief Returns exp(-x) in Q16
+ *
+ * @param x exponent in Q12
+ * @return uint16_t
+ */
+uint16_t exp_smoother::exp_q16(uint32_t x)
+{
+    uint16_t index = x >> 8;
+    uint32_t fraction = (x & 0xFF) << 4;
+    uint32_t taylor = 0;
+
+    if (index >= EXP_TABLE_SIZE)
+        return 0;
+
+    /* exp(-f) ~ 1 - f + f^2 / 2 for the remaining f < 1 / 16 */
+    taylor = 65536 - fraction + ((fraction * fraction) >> 17);
+    return ((uint32_t) pgm_read_word(&exp_table[index]) * taylor) >> 16;
+}
+
+/**
+ * @brief Applies filtering to input value.
+ *
+ * @param input_value 0 - 32767
+ * @param time_delta ms since the previous call
+ * @return int16_t
+ */
+int16_t exp_smoother::calc(int16_t input_value, uint16_t time_delta)
+{
+    int32_t difference = ((int32_t) input_value << 8) - m_value;
+    int32_t difference_high = difference >> 8;
+    uint8_t difference_low = difference & 0xFF;
+    uint32_t beta = 0;
+
+    if (time_delta >= 1000)
+    {
+        WARN(F("EWMA filter is running too slow for its window_size"));
+        return (m_value + 128) >> 8;
+    }
+
+    /* Share of the input. 1 - 0.05^((1 - dt) * window_size) in Q16 */
+    beta = 65536 - exp_q16((m_rate * (1000 - time_delta)) >> 16);
+
+    /* difference * beta in two halves so the product fits 32 bits */
+    m_value += (difference_high * (int32_t) beta + (int32_t) ((difference_low * beta) >> 8)) >> 8;
+    return (m_value + 128) >> 8;
+}
@@ -33,16 +33,191 @@
 
 extern void fill_solid(struct CHSV *leds, int numToFill, const struct CRGB &hsvColor);
 
-struct moving_average_filter
+/**
+ * @brief Gamma 2.2 correction table. Read with pgm_read_byte(&gamma8_table[value])
+ * 
+ */
+extern const uint8_t gamma8_table[256] PROGMEM;
+
+/**
+ * @brief Accumulator type of the templated filters. 
+ *      Integers sum in 32 bits, floating point types in themselves
+ *
+ * @tparam T sample type
+ */
+template <typename T>
+struct filter_accumulator
+{
+    typedef int32_t type;
+};
+
+template <>
+struct filter_accumulator<float>
+{
+    typedef float type;
+};
+
+template <>
+struct filter_accumulator<double>
+{
+    typedef double type;
+};
+
+/**
+ * @brief Average of the last N samples. Running sum keeps calc() O(1).
+ *      No allocation, window is a member array
+ *
+ * @tparam T sample type
+ * @tparam N window length. Power of two turns the division into a shift
+ * @tparam ACC sum type. Has to hold N * max(T)
+ */
+template <typename T, uint8_t N, typename ACC = typename filter_accumulator<T>::type>
+struct moving_average
 {
-    float _window[10];
-    float _sampleTotal;
-    uint8_t _curReadIndex;
-    float _sampleAvg;
+    static_assert(N > 0, "moving_average: N has to be at least 1");
+
+    T m_window[N] = {};
+    ACC m_sum = 0;
+    uint8_t m_index = 0;
+
+    /**
+     * @brief Adds the sample & returns the average of the window.
+     *      Window starts filled with zeros
+     *
+     * @param value
+     * @return T
+     */
+    T calc(T value)
+    {
+        m_sum += (ACC) value - (ACC) m_window[m_index];
+        m_window[m_index] = value;
+
+        if (++m_index >= N)
+            m_index = 0;
+
+        return m_sum / (ACC) N;
+    }
+
+    /**
+     * @brief Fills the window with the value
+     *
+     * @param value
+     */
+    void reset(T value = 0)
+    {
+        for (uint8_t i = 0; i < N; i++)
+            m_window[i] = value;
+
+        m_sum = (ACC) value * N;
+        m_index = 0;
+    }
+};
+
+/**
+ * @brief Exponentially weighted moving average with alpha of 1 / 2^SHIFT.
+ *      State is kept scaled by 2^SHIFT, so integer types keep the fraction
+ *      & calc() is an add, a subtract and two shifts.
+ *
+ * @tparam T sample type
+ * @tparam SHIFT alpha = 1 / 2^SHIFT. Time constant is ~2^SHIFT calls
+ * @tparam ACC state type. Has to hold max(T) * 2^SHIFT
+ */
+template <typename T, uint8_t SHIFT, typename ACC = typename filter_accumulator<T>::type>
+struct shift_ewma
+{
+    ACC m_state = 0;
+
+    /**
+     * @brief Steps the average towards the value
+     *
+     * @param value
+     * @return T
+     */
+    T calc(T value)
+    {
+        m_state += (ACC) value - m_state / (ACC) (1UL << SHIFT);
+        return get();
+    }
+
+    /**
+     * @brief Returns the average without stepping it
+     *
+     * @return T
+     */
+    T get() { return m_state / (ACC) (1UL << SHIFT); }
+
+    void reset(T value = 0) { m_state = (ACC) value * (ACC) (1UL << SHIFT); }
+};
+
+/**
+ * @brief Limits how much the output moves per step. 
+ *      Integer replacement of constantChangeRater without millis()
+ *
+ * @tparam T value type. Integers up to 16 bits or floating point
+ * @tparam ACC type of the differences. Has to hold 2 * max(T) signed
+ */
+template <typename T, typename ACC = typename filter_accumulator<T>::type>
+struct slew_limiter
+{
+    T m_max_step;
+    T m_value = 0;
+
+    /**
+     * @brief Construct a new slew limiter object
+     *
+     * @param max_step largest change per step
+     */
+    slew_limiter(T max_step) : m_max_step(max_step) {}
+
+    /**
+     * @brief Moves the output towards the target by at most steps * max_step
+     *
+     * @param target
+     * @param steps elapsed steps. e.g. ms from frame_context
+     * @return T
+     */
+    T calc(T target, uint16_t steps = 1)
+    {
+        ACC max_change = (ACC) m_max_step * steps;
+        ACC difference = (ACC) target - (ACC) m_value;
+
+        if (difference > max_change)
+            difference = max_change;
+        else if (difference < -max_change)
+            difference = -max_change;
 
-    float calc(float val);
+        m_value = (T) ((ACC) m_value + difference);
+        return m_value;
+    }
+
+    void reset(T value = 0) { m_value = value; }
 };
 
+/**
+ * @brief Scales every byte of the array by scale / 256. 
+ *      Per pixel decay for fading trails. 255 keeps the values, 0 clears them
+ *
+ * @param data bytes to scale in place. e.g. CRGB array cast to uint8_t *
+ * @param count number of bytes
+ * @param scale
+ */
+void decay_array(uint8_t *__restrict__ data, uint16_t count, uint8_t scale);
+
+/**
+ * @brief Steps every byte of state towards the matching input byte by alpha / 256.
+ *      One EWMA step per byte, for per pixel smoothing without a filter object per pixel.
+ *      Step is rounded away from zero, so state settles exactly on a constant input
+ *
+ * @param state filtered bytes, updated in place
+ * @param input new bytes. Same length as state
+ * @param count number of bytes
+ * @param alpha share of the input. 255 copies the input, 0 keeps the state
+ */
+void ewma_array(uint8_t *__restrict__ state, const uint8_t *__restrict__ input, uint16_t count, uint8_t alpha);
+
+/* Two sample float average. Was a 10 entry array which used only 2 */
+typedef moving_average<float, 2> moving_average_filter;
+
 struct weighted_moving_average_filter
 {
     float _Alpha = 0.05; // smoothing factor
@@ -116,11 +291,111 @@ struct EWMAtest
         */
 
         m_last_val =  m_last_val + (input_value - m_last_val) * (1.0F - alpha);
-        m_time_elapsed = micros();
+        m_time_elapsed = millis();
         return m_last_val;
     }
 };
 
+#define EXP_TABLE_SIZE 192
+
+extern const uint16_t exp_table[EXP_TABLE_SIZE] PROGMEM;
+
+/**
+ * @brief Fixed point EWMAtest. Same response for the same window_size & call interval,
+ *      without pow() & software float on every call.
+ *      0.05^((1 - dt) * window_size) is evaluated as exp(-x) from exp_table.
+ *
+ */
+struct exp_smoother
+{
+    uint32_t m_rate = 0;    // ln(20) * window_size per ms. Q16 of the Q12 exponent
+    int32_t m_value = 0;    // Q8
+
+    exp_smoother(float window_size = 0.30F);
+
+    static uint16_t exp_q16(uint32_t x);
+
+    int16_t calc(int16_t input_value, uint16_t time_delta);
+
+    /**
+     * @brief Returns the filtered value without stepping it
+     *
+     * @return int16_t
+     */
+    int16_t get() { return (m_value + 128) >> 8; }
+};
+
+/**
+ * @brief Envelope follower with separate attack & release times.
+ *      Integer one pole filter. Time constant is picked by the direction of the input:
+ *      rising input uses attack time, falling input release time.
+ *
+ */
+struct envelope_follower
+{
+    uint16_t m_attack_ms;
+    uint16_t m_release_ms;
+    uint32_t m_value = 0; // Q8
+    uint32_t m_last_time = 0;
+
+    /**
+     * @brief Construct a new envelope follower object
+     *
+     * @param attack_ms time constant for rising input
+     * @param release_ms time constant for falling input
+     */
+    envelope_follower(uint16_t attack_ms = 5, uint16_t release_ms = 150)
+        : m_attack_ms(attack_ms), m_release_ms(release_ms) {}
+
+    /**
+     * @brief Steps the envelope towards the input value
+     *
+     * @param input_value
+     * @return uint16_t envelope
+     */
+    uint16_t calc(uint16_t input_value)
+    {
+        uint32_t now = millis();
+        uint32_t time_delta = now - m_last_time;
+
+        m_last_time = now;
+        return calc(input_value, time_delta);
+    }
+
+    /**
+     * @brief Steps the envelope towards the input value 
+     *      with the time delta from the caller. e.g. frame_context
+     *
+     * @param input_value
+     * @param time_delta ms since the previous step
+     * @return uint16_t envelope
+     */
+    uint16_t calc(uint16_t input_value, uint32_t time_delta)
+    {
+        uint32_t target = (uint32_t) input_value << 8;
+        uint16_t time_constant = target > m_value ? m_attack_ms : m_release_ms;
+        uint16_t k = 256;
+
+        /* k = dt / (tau + dt) in Q8 */
+        if (time_delta < time_constant)
+            k = (time_delta << 8) / (time_constant + time_delta);
+
+        if (target > m_value)
+            m_value += ((target - m_value) * k) >> 8;
+        else
+            m_value -= ((m_value - target) * k) >> 8;
+
+        return m_value >> 8;
+    }
+
+    /**
+     * @brief Returns the current envelope without stepping it
+     *
+     * @return uint16_t
+     */
+    uint16_t get() { return m_value >> 8; }
+};
+
 /**
  * @brief template for a constant rate of change
  *  Initialized with max rate of change +, then the time in ms
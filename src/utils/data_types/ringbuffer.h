@@ -129,6 +129,31 @@ public:
         return ( _head - _tail + _size) % _size + 1;
     }
 
+    /**
+     * @brief Returns reference to an element counted back from the newest one.
+     *      Doesn't copy or remove the element.
+     *
+     * @note age has to be smaller than the buffer's size
+     *
+     * @param age 0 for the newest element, 1 for the one before it...
+     * @return T&
+     */
+    T &peek(uint16_t age)
+    {
+        int32_t _head = head;
+        int32_t _size = size;
+
+        #ifdef DEBUG_CHECKS
+        if (age >= size)
+        {
+            WARN(F("ringbuffer: peek age is larger than buffer"));
+            age = size - 1;
+        }
+        #endif
+
+        return buffer[(_head - 1 - age + 2 * _size) % _size];
+    }
+
     /**
      * @brief Inserts an element at the buffer's head.
      * 
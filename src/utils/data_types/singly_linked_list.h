@@ -44,21 +44,40 @@ struct node {
     T *data;
     node *next_node;
 
+    /* List handler the node belongs to. nullptr when not in a list */
+    const void *owner = nullptr;
+
     node(T *_data = nullptr, node *_next_node = nullptr) : data(_data), next_node(_next_node) {}
 };
 
+/**
+ * @brief A node with a pointer to the previous node.
+ *      Makes removal from the list constant time, at the cost of one pointer per node.
+ * 
+ * @tparam T The type of data stored in the node.
+ */
+template <typename T>
+struct dl_node : node<T> {
+    dl_node *prev_node = nullptr;
+
+    dl_node(T *_data = nullptr, dl_node *_next_node = nullptr) : node<T>(_data, _next_node) {}
+};
+
 /**
  * @brief A singly linked list implementation.
  * 
  * This class provides handling functions for a singly linked list. It allows adding, removing, and finding nodes in the list.
  * The list is composed of nodes, where each node contains a pointer to the data and a pointer to the next node in the list.
+ * Append and find are constant time. Remove is constant time with dl_node, othervise linear.
  * 
  * @tparam T The type of data stored in the list.
+ * @tparam NODE node<T> or dl_node<T>
  */
-template <typename T>
+template <typename T, typename NODE = node<T>>
 class handler
 {
-    node<T> *_head = nullptr;
+    NODE *_head = nullptr;
+    NODE *_tail = nullptr;
 
 public:
 
@@ -68,35 +87,36 @@ public:
     /**
      * @brief Returns the matching node in the list.
      *
-     * @note Assumes that the handler always starts the operations at the list_head 
+     * @note Constant time. Checks the node's owner
      * 
      * @param node A pointer to the node to be found.
      * @return A pointer to the matching node, or nullptr if not found.
      */
-    node<T> *find(node<T> *node)
+    NODE *find(NODE *node)
     {
-        sl_list::node<T> *seek_node = _head;
-
-        /* Check if list head is the target node */
-        if (seek_node == node) return _head;
-
-        while (seek_node != nullptr)
-        {
-            if (seek_node == node) break;
-
-            seek_node = next(seek_node);
-        }
+        if (node == nullptr || node->owner != this)
+            return nullptr;
 
-        return seek_node;
+        return node;
     }
 
 private:
 
-    __attribute__((always_inline)) inline void clean_next_ptr(node<T> *node)
+    __attribute__((always_inline)) inline void clean_next_ptr(NODE *node)
     {
         if (node == nullptr) return;
 
         node->next_node = nullptr;
+        node->owner = nullptr;
+    }
+
+    /* Previous node pointers are only kept in dl_node */
+    __attribute__((always_inline)) inline void set_prev(node<T> *, node<T> *) {}
+    __attribute__((always_inline)) inline void set_prev(dl_node<T> *node, dl_node<T> *prev) 
+    {
+        if (node == nullptr) return;
+
+        node->prev_node = prev;
     }
 
     /**
@@ -104,14 +124,13 @@ private:
      *
      * It searches for the preceding node of the target node in the list.
      * If the target node is found, a pointer to the preceding node is returned.
-     * If the target node is not found, nullptr is returned.
+     * If the target node is not found or it's the head of the list, nullptr is returned.
      * 
-     * @note If the target node is the head of the list, the target node is returned.
-     * @return A pointer to the preceding node, or nullptr if not found.
+     * @return A pointer to the preceding node, or nullptr.
      */
-    inline node<T> *find_preceding_node(const node<T> *target_node)
+    inline NODE *find_preceding_node(const sl_list::node<T> *target_node)
     {
-        sl_list::node<T> *seek_head = _head;
+        NODE *seek_head = _head;
 
         if (!seek_head)
         {
@@ -119,20 +138,18 @@ private:
             return nullptr;
         }
 
-
-        /* check if target node is the head of the list */
-        if (seek_head == target_node) return seek_head;
-
-        while (next(seek_head) != target_node)
-        {
+        while (seek_head != nullptr && next(seek_head) != target_node)
             seek_head = next(seek_head);
 
-            if (seek_head == nullptr) break;
-        }
-
         return seek_head;
     }
 
+    /* dl_node knows its preceding node */
+    inline dl_node<T> *find_preceding_node(const dl_node<T> *target_node)
+    {
+        return target_node->prev_node;
+    }
+
 public:
 
     /**
@@ -144,19 +161,19 @@ public:
      * @param current_pos A pointer to the current position in the list.
      * @return A pointer to the next node, or nullptr if there isn't a next node.
      */
-    __attribute__((always_inline)) inline node<T> *next(node<T> *current_pos) 
+    __attribute__((always_inline)) inline NODE *next(NODE *current_pos) 
     {
         if (current_pos == nullptr) 
             return current_pos;
 
-        return current_pos->next_node;
+        return static_cast<NODE *>(current_pos->next_node);
     }
 
     /**
      * @brief Returns the first node in the list
      * 
      */
-    __attribute__((always_inline)) inline node<T> *head()
+    __attribute__((always_inline)) inline NODE *head()
     {
         return _head;
     }
@@ -165,13 +182,11 @@ public:
      * @brief Returns the last node in the list 
      * 
      */
-    __attribute__((always_inline)) inline node<T> *tail()
+    __attribute__((always_inline)) inline NODE *tail()
     {
-        return find_preceding_node(nullptr);
+        return _tail;
     }
 
-    
-
     /**
      * @brief Appends a new node to the list.
      * 
@@ -180,18 +195,21 @@ public:
      * 
      * @param new_node A pointer to the new node to be appended.
      */
-    __attribute__((always_inline)) inline void append(node<T> *new_node)
+    __attribute__((always_inline)) inline void append(NODE *new_node)
     {
-        sl_list::node<T> *ptr = nullptr;
+        new_node->next_node = nullptr;
+        new_node->owner = this;
+        set_prev(new_node, _tail);
 
         if (_head == nullptr)
         {
             _head = new_node;
+            _tail = new_node;
             return;
         }
 
-        ptr = tail();
-        ptr->next_node = new_node;
+        _tail->next_node = new_node;
+        _tail = new_node;
     }
 
     /**
@@ -203,13 +221,24 @@ public:
      * @param node A pointer to the node to be removed.
      * @return 0 if the node is successfully removed, 1 otherwise.
      */
-    __attribute__((always_inline)) inline bool remove(node<T> *node)
+    __attribute__((always_inline)) inline bool remove(NODE *node)
     {
-        sl_list::node<T> *preceding_node = nullptr;
+        NODE *preceding_node = nullptr;
+
+        if (find(node) == nullptr)
+        {
+            ERROR(F("remove: node: "), (uintptr_t) node, F(" not found in linked list"));
+            return 1;
+        }
 
         if (node == _head)
         {
             _head = next(node);
+            set_prev(_head, nullptr);
+
+            if (_tail == node)
+                _tail = nullptr;
+
             clean_next_ptr(node);
             return 0;
         }
@@ -218,7 +247,7 @@ public:
 
         if (preceding_node == nullptr)
         {
-            ERROR(F("remove: node: "), (uint32_t) node, F(" not found in linked list"));
+            ERROR(F("remove: node: "), (uintptr_t) node, F(" not found in linked list"));
             return 1;
         }
 
@@ -226,10 +255,16 @@ public:
          * Example case: [preceding node] [node] [another node]
          * Sets preceding node's next_node pointer to another node. 
          */
-        preceding_node->next_node = next(preceding_node->next_node);
+        preceding_node->next_node = node->next_node;
+        set_prev(next(node), preceding_node);
+
+        if (_tail == node)
+            _tail = preceding_node;
+
         clean_next_ptr(node);
+        set_prev(node, nullptr);
 
-        INFO(F("Removed node: "), (uint16_t) node);
+        INFO(F("Removed node: "), (uintptr_t) node);
         return 0;
     }
 };
@@ -28,6 +28,7 @@
 #include <FastLED.h>
 #include "../../config.h"
 #include "../debug.h"
+#include "../colorMath.h"
 
 /**
  * @brief "virtual" CRGB array
@@ -44,7 +45,8 @@ struct virtual_led_array
      * 
      * @param start Start address of the array
      * @param end  End address of the array
-     * @param clear_old_area 1 to set all pixels to black before updating arrays position to a new value 
+     * @param clear_old_area 1 to set all pixels to black before updating arrays position to a new value.
+     *      The new area is set to black too, so grown pixels don't keep stale data
      * @return true 
      * @return false 
      */
@@ -67,9 +69,113 @@ struct virtual_led_array
 
         data_array_start = start;
         data_array_end = end;
+
+        if (clear_old_area)
+            fill_solid(data_array_start, size(), CRGB::Black);
+
+        clear_dirty();
         return 0;
     }
 
+    /**
+     * @brief Marks pixels [first, end) as changed. 
+     *      Only the changed range has to be pushed to the leds
+     * 
+     * @param first first changed pixel
+     * @param end one past the last changed pixel
+     */
+    void mark_dirty(uint16_t first, uint16_t end)
+    {
+        if (end > size())
+            end = size();
+
+        if (first >= end)
+            return;
+
+        if (!is_dirty())
+        {
+            dirty_first = first;
+            dirty_end = end;
+            return;
+        }
+
+        if (first < dirty_first)
+            dirty_first = first;
+
+        if (end > dirty_end)
+            dirty_end = end;
+    }
+
+    /**
+     * @brief Marks the whole array as changed
+     * 
+     */
+    void mark_dirty() {mark_dirty(0, size());}
+
+    /**
+     * @brief Returns 1 if any pixel is marked as changed
+     * 
+     */
+    bool is_dirty() {return dirty_first < dirty_end;}
+
+    /**
+     * @brief Returns address of the first changed pixel
+     * 
+     */
+    CRGB *get_dirty_start() {return data_array_start + dirty_first;}
+
+    /**
+     * @brief Returns address one past the last changed pixel
+     * 
+     */
+    CRGB *get_dirty_end() {return data_array_start + dirty_end;}
+
+    /**
+     * @brief Clears the changed range
+     * 
+     */
+    void clear_dirty()
+    {
+        dirty_first = 0;
+        dirty_end = 0;
+    }
+
+    /**
+     * @brief Returns address of the first pixel
+     * 
+     */
+    CRGB *get_start() {return data_array_start;}
+
+    /**
+     * @brief Scales all pixels by scale / 256 in one pass. e.g. fading trails
+     * 
+     * @param scale 255 keeps the colors, 0 sets them black
+     */
+    void decay(uint8_t scale)
+    {
+        decay_array((uint8_t *) data_array_start, size() * sizeof(CRGB), scale);
+        mark_dirty();
+    }
+
+    /**
+     * @brief Steps all pixels towards the target colors by alpha / 256 in one pass.
+     *      Per pixel temporal smoothing, e.g. flicker suppression
+     * 
+     * @param target colors to move towards. Has to hold size() pixels
+     * @param alpha share of the target per call. 255 copies the target
+     */
+    void smooth(const CRGB *target, uint8_t alpha)
+    {
+        if (target == nullptr)
+        {
+            ERROR(F("virtual_array: Nullpointer was passed as smoothing target"));
+            return;
+        }
+
+        ewma_array((uint8_t *) data_array_start, (const uint8_t *) target, size() * sizeof(CRGB), alpha);
+        mark_dirty();
+    }
+
     /**
      * @brief Returns the size of the virtual array's section
      * 
@@ -116,6 +222,10 @@ struct virtual_led_array
 private:
     CRGB *data_array_start = nullptr;
     CRGB *data_array_end = nullptr;
+
+    /* Changed pixels [dirty_first, dirty_end) */
+    uint16_t dirty_first = 0;
+    uint16_t dirty_end = 0;
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,137 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Mikko Johannes Heinänen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _EVENT_QUEUE_H_
+#define _EVENT_QUEUE_H_
+
+#include <Arduino.h>
+#include <inttypes.h>
+#include "../config.h"
+
+static_assert((EVENT_QUEUE_SIZE & (EVENT_QUEUE_SIZE - 1)) == 0 && EVENT_QUEUE_SIZE <= 128,
+    "EVENT_QUEUE_SIZE has to be a power of two, max 128");
+
+/**
+ * @brief Events dispatched to the effects by led_manager. 
+ *      Effects subscribe with audioMode::subscribe()
+ */
+typedef enum : uint8_t
+{
+    event_window_ready = 0,     // sampling window is full. Posted by the sampling isr
+    event_serial_command,       // data: received byte. Posted with led_manager::post_event()
+    event_type_count
+} event_type;
+
+struct event
+{
+    event_type type;
+    uint8_t data;
+};
+
+/**
+ * @brief Fixed size fifo of events. Safe to post from isrs and the main loop.
+ * @note Indices run freely and wrap at 256. head - tail is the number of queued events.
+ *       Unlike ringbuffer, a full queue drops the new event instead of 
+ *       overwriting the oldest one, so the producer never touches tail.
+ */
+class event_queue
+{
+private:
+    event buffer[EVENT_QUEUE_SIZE];
+    volatile uint8_t head = 0;
+    volatile uint8_t tail = 0;
+    volatile uint8_t dropped = 0;
+
+public:
+
+    /**
+     * @brief Queues an event. Callable from isrs
+     * 
+     * @param type 
+     * @param data 
+     * @return true queue is full, event was dropped
+     * @return false 
+     */
+    bool post(event_type type, uint8_t data = 0)
+    {
+        /* Keeps interrupts disabled when called from an isr */
+        uint8_t sreg = SREG;
+        cli();
+
+        if ((uint8_t)(head - tail) >= EVENT_QUEUE_SIZE)
+        {
+            if (dropped != 0xFF)
+                dropped++;
+
+            SREG = sreg;
+            return 1;
+        }
+
+        buffer[head & (EVENT_QUEUE_SIZE - 1)] = {type, data};
+        head++;
+
+        SREG = sreg;
+        return 0;
+    }
+
+    /**
+     * @brief Takes the oldest event. Only led_manager consumes events
+     * 
+     * @param e 
+     * @return true queue is empty
+     * @return false 
+     */
+    bool take(event &e)
+    {
+        if (is_empty())
+            return 1;
+
+        /* Only the consumer moves tail. Producers can't touch the slot until tail passes it */
+        e = buffer[tail & (EVENT_QUEUE_SIZE - 1)];
+        tail++;
+        return 0;
+    }
+
+    bool is_empty() {return head == tail;}
+
+    /**
+     * @brief Returns the number of events dropped on a full queue & resets the counter
+     * 
+     * @return uint8_t 
+     */
+    uint8_t take_dropped()
+    {
+        uint8_t count;
+
+        cli();
+        count = dropped;
+        dropped = 0;
+        sei();
+        return count;
+    }
+};
+
+extern event_queue event_bus;
+
+#endif
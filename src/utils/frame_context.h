@@ -0,0 +1,57 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Mikko Johannes Heinänen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _FRAME_CONTEXT_H_
+#define _FRAME_CONTEXT_H_
+
+#include <inttypes.h>
+
+/**
+ * @brief Audio analysis shared by all effects. 
+ *      Updated once per frame by led_manager, see led_manager::set_audio_input()
+ */
+struct audio_features
+{
+    uint16_t peak = 0;                  // peak envelope in adc units
+    uint16_t rms = 0;                   // rms envelope in adc units
+    uint16_t dominant_frequency = 0;    // loudest frequency of the latest window in Hz
+    uint16_t window_count = 0;          // incremented for every analysed window
+};
+
+/**
+ * @brief State of the current frame, passed to audioMode::update().
+ *      Clock is read once per frame, so every effect sees the same time.
+ * @note dt_us is the time since the previous frame. 
+ *       Effects updated every nth frame see only the last frame's share
+ */
+struct frame_context
+{
+    uint32_t time_us;                   // micros() at the start of the frame
+    uint32_t time_ms;                   // ms since the first frame
+    uint32_t dt_us;                     // time since the previous frame
+    uint32_t frame_number;
+    const audio_features &audio;
+};
+
+#endif
@@ -34,7 +34,7 @@
  * @return false 
  */
 bool ledStrip::_add_effect(
-        sl_list::node<audioMode> &effect_node,
+        sl_list::dl_node<audioMode> &effect_node,
         CRGB *pixel_start,
         CRGB *pixel_end)
 {
@@ -50,15 +50,19 @@ bool ledStrip::_add_effect(
         return 1;
     }
 
-    if (effect_list.find(&effect_node))
+    /* Effect can be only on one led strip */
+    if (effect_node.owner != nullptr)
     {
         ERROR(F("add_effect: effect already added"));
         return 1;
     }
 
     effect_list.append(&effect_node);
+    effect_node.data->owner_strip = this;
 
     effect_node.data->resize(pixel_start, pixel_end);
+    mark_dirty(effect_node.data->get_strip_start(), effect_node.data->get_strip_end());
+    update_occlusion();
 
     #ifdef DEBUG_CHECKS
     INFO(F("add_effect: added effect"));
@@ -117,19 +121,203 @@ bool ledStrip::add_effect(audioMode &audio_effect)
  */
 bool ledStrip::remove_effect(audioMode &audio_effect)
 {
-    return effect_list.remove(&audio_effect.get_node());
+    uint8_t i = 0;
+
+    /* Outgoing effect of a cross-fade. Jump to the end of it */
+    if (transition_in != nullptr && &audio_effect == transition_out)
+    {
+        finish_transition();
+        return 0;
+    }
+
+    /* Incoming effect of a cross-fade. Cancel it */
+    if (&audio_effect == transition_in)
+    {
+        transition_in = nullptr;
+        transition_out = nullptr;
+    }
+
+    if (effect_list.remove(&audio_effect.get_node()))
+        return 1;
+
+    audio_effect.owner_strip = nullptr;
+
+    if (audio_effect.is_layer())
+    {
+        while (i < layer_count && layers[i] != &audio_effect)
+            i++;
+
+        /* Incoming effect of a cross-fade isn't in the layer stack */
+        if (i < layer_count)
+        {
+            for (; i + 1 < layer_count; i++)
+                layers[i] = layers[i + 1];
+
+            layer_count--;
+            layers[layer_count] = nullptr;
+        }
+
+        assign_layer(audio_effect, nullptr, nullptr, blend_replace, 255, 0);
+    }
+
+    audio_effect.occluded = 0;
+    update_occlusion();
+
+    /* Effect's pixels are no longer updated. Push their last state */
+    mark_dirty(0, led_rgb_data_size);
+    return 0;
+}
+
+/**
+ * @brief Marks pixels [start, end) as changed
+ * 
+ * @param start index of the first changed pixel
+ * @param end index one past the last changed pixel
+ */
+void ledStrip::mark_dirty(uint16_t start, uint16_t end)
+{
+    if (end > led_rgb_data_size)
+        end = led_rgb_data_size;
+
+    if (start >= end)
+        return;
+
+    if (!is_dirty())
+    {
+        dirty_start = start;
+        dirty_end = end;
+        return;
+    }
+
+    if (start < dirty_start)
+        dirty_start = start;
+
+    if (end > dirty_end)
+        dirty_end = end;
 }
 
 /**
- * @brief Updates the led strip's effects
+ * @brief Marks pixels [start, end) as changed
  * 
+ * @param start address of the first changed pixel
+ * @param end address one past the last changed pixel
+ */
+void ledStrip::mark_dirty(CRGB *start, CRGB *end)
+{
+    if (start < led_rgb_data || end < start)
+    {
+        WARN(F("mark_dirty: range outside of the led strip"));
+        return;
+    }
+
+    mark_dirty(start - led_rgb_data, end - led_rgb_data);
+}
+
+/**
+ * @brief Limits how often the strip is pushed to the leds.
+ *      Changes made in between are collected and pushed on the next refresh.
+ * @note Only applies to strips with own controller
+ * 
+ * @param fps max refresh rate. 0 pushes on every change
  * @return true 
  * @return false 
  */
-bool ledStrip::update()
+bool ledStrip::set_refresh_rate(uint16_t fps)
+{
+    if (fps == 0)
+    {
+        show_period_us = 0;
+        return 0;
+    }
+
+    if (fps > 1000)
+    {
+        WARN(F("set_refresh_rate: fps: "), fps, F(" too high"));
+        return 1;
+    }
+
+    show_period_us = 1000000UL / fps;
+    last_show_time = micros();
+    return 0;
+}
+
+/**
+ * @brief Pushes the changed pixels to the leds through the strip's controller.
+ * @note Pixels are sent up to the last changed one. 
+ *       Leds after it keep their previous values
+ * 
+ * @return true if strip doesn't have a controller
+ * @return false pixels were pushed, there were no changes or refresh isn't due
+ */
+bool ledStrip::show()
+{
+    uint32_t time_now = 0;
+
+    last_push_us = 0;
+
+    if (controller == nullptr)
+        return 1;
+
+    /* Current limit of the output buffer depends on the global brightness */
+    if (output_buffer != nullptr && FastLED.getBrightness() != last_global_brightness)
+    {
+        last_global_brightness = FastLED.getBrightness();
+        mark_dirty(0, led_rgb_data_size);
+    }
+
+    if (!is_dirty())
+        return 0;
+
+    if (show_period_us)
+    {
+        time_now = micros();
+
+        if (time_now - last_show_time < show_period_us)
+            return 0;
+
+        last_show_time = time_now;
+    }
+
+    update_output();
+
+    PROFILE_START(show_start);
+    time_now = micros();
+    controller->show(output_buffer != nullptr ? output_buffer : led_rgb_data, dirty_end, FastLED.getBrightness());
+    last_push_us = micros() - time_now;
+    PROFILE_END(profiler.show, show_start);
+    clear_dirty();
+    return 0;
+}
+
+/**
+ * @brief Writes the changed pixels to the output buffer when post processing is enabled
+ * 
+ */
+void ledStrip::update_output()
+{
+    if (output_buffer == nullptr)
+        return;
+
+    PROFILE_START(post_process_start);
+    post_process();
+    PROFILE_END(profiler.post_process, post_process_start);
+}
+
+/**
+ * @brief Updates the led strip's effects which are due on this frame
+ * 
+ * @return true if the strip has changed pixels
+ * @return false 
+ */
+bool ledStrip::update(const frame_context &context)
 {
-    sl_list::node<audioMode> *effect_node = effect_list.head();
-    bool led_changed = 0;
+    sl_list::dl_node<audioMode> *effect_node = effect_list.head();
+    CRGB *dirty_range_start = nullptr;
+    CRGB *dirty_range_end = nullptr;
+    bool changed = 0;
+
+    if (transition_in != nullptr)
+        step_transition(context.dt_us);
 
     while (effect_node != nullptr)
     {
@@ -140,15 +328,719 @@ bool ledStrip::update()
             continue;
         }
 
-        if (effect_node->data->update())
-                led_changed = 1;
+        /* Event driven, not this effect's frame or hidden under an opaque layer */
+        if (effect_node->data->is_event_driven() || !effect_node->data->frame_tick() || effect_node->data->occluded)
+        {
+            effect_node = effect_list.next(effect_node);
+            continue;
+        }
+
+        PROFILE_START(effect_start);
+        changed = effect_node->data->update(context);
+        PROFILE_END(effect_node->data->profile, effect_start);
+
+        if (effect_node->data->take_dirty_range(changed, dirty_range_start, dirty_range_end))
+            mark_dirty(dirty_range_start, dirty_range_end);
+
+        effect_node = effect_list.next(effect_node);
+    }
+
+    if (transition_in != nullptr)
+        blend_transition();
+
+    return is_dirty();
+}
+
+/**
+ * @brief Passes the event to the subscribed effects
+ * 
+ * @param e 
+ * @return true if any led changed
+ * @return false 
+ */
+bool ledStrip::dispatch_event(const event &e)
+{
+    sl_list::dl_node<audioMode> *effect_node = effect_list.head();
+    CRGB *dirty_range_start = nullptr;
+    CRGB *dirty_range_end = nullptr;
+    bool changed = 0;
+
+    while (effect_node != nullptr)
+    {
+        if (effect_node->data == nullptr ||
+            !effect_node->data->is_subscribed(e.type) ||
+            effect_node->data->occluded)
+        {
+            effect_node = effect_list.next(effect_node);
+            continue;
+        }
+
+        changed = effect_node->data->on_event(e);
+
+        if (effect_node->data->take_dirty_range(changed, dirty_range_start, dirty_range_end))
+            mark_dirty(dirty_range_start, dirty_range_end);
 
         effect_node = effect_list.next(effect_node);
     }
 
-    return led_changed;
+    return is_dirty();
 }
 
 ledStrip::~ledStrip()
 {
+    free(current_block_sums);
+}
+
+/**
+ * @brief Adds effect which renders to its own layer buffer.
+ *      Layer is blended on top of the strip's other effects
+ *      in the post processing pass.
+ * @note Requires the strip's own controller & enable_post_processing(). 
+ *       The output buffer costs 3 bytes per led on top of the layer buffer
+ * 
+ * @param audio_effect 
+ * @param pixel_start layer's first pixel on the strip
+ * @param pixel_end one past layer's last pixel on the strip
+ * @param layer_buffer buffer the effect renders to. (pixel_end - pixel_start) pixels
+ * @param mode blend mode
+ * @param z_order higher is on top
+ * @param alpha used by blend_alpha
+ * @return true 
+ * @return false 
+ */
+bool ledStrip::add_layer(
+        audioMode &audio_effect,
+        CRGB *pixel_start,
+        CRGB *pixel_end,
+        CRGB *layer_buffer,
+        blend_mode mode,
+        uint8_t z_order,
+        uint8_t alpha)
+{
+    uint8_t i = layer_count;
+
+    if (output_buffer == nullptr)
+    {
+        ERROR(F("add_layer: layers are blended in post processing. Call enable_post_processing() first"));
+        return 1;
+    }
+
+    if (layer_count >= MAX_LAYERS)
+    {
+        ERROR(F("add_layer: too many layers. See MAX_LAYERS"));
+        return 1;
+    }
+
+    if (layer_buffer == nullptr || pixel_start < led_rgb_data || 
+        pixel_end > led_rgb_data + led_rgb_data_size || pixel_start > pixel_end)
+    {
+        ERROR(F("add_layer: invalid layer range"));
+        return 1;
+    }
+
+    assign_layer(audio_effect, pixel_start, pixel_end, mode, alpha, z_order);
+
+    /* Keep layers sorted by z order */
+    while (i && layers[i - 1]->layer_z > z_order)
+    {
+        layers[i] = layers[i - 1];
+        i--;
+    }
+
+    layers[i] = &audio_effect;
+    layer_count++;
+
+    if (_add_effect(audio_effect.get_node(), layer_buffer, layer_buffer + (pixel_end - pixel_start)))
+    {
+        for (; i + 1 < layer_count; i++)
+            layers[i] = layers[i + 1];
+
+        layer_count--;
+        assign_layer(audio_effect, nullptr, nullptr, blend_replace, 255, 0);
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Changes the blend mode, z order & alpha of a layer on the strip
+ * 
+ * @param audio_effect layer added with add_layer()
+ * @param mode blend mode
+ * @param z_order higher is on top
+ * @param alpha used by blend_alpha
+ * @return true effect isn't a layer on the strip
+ * @return false 
+ */
+bool ledStrip::set_layer(
+        audioMode &audio_effect,
+        blend_mode mode,
+        uint8_t z_order,
+        uint8_t alpha)
+{
+    uint8_t i = 0;
+
+    while (i < layer_count && layers[i] != &audio_effect)
+        i++;
+
+    if (i == layer_count)
+    {
+        ERROR(F("set_layer: effect isn't a layer on the led strip"));
+        return 1;
+    }
+
+    assign_layer(audio_effect, audio_effect.layer_position, audio_effect.layer_end, mode, alpha, z_order);
+    sort_layers();
+    update_occlusion();
+
+    /* Layers below may have been uncovered */
+    mark_dirty(audio_effect.layer_position, audio_effect.layer_end);
+    return 0;
+}
+
+/**
+ * @brief Sets the effect's layer placement & blending. nullptr position turns the layer off
+ * 
+ * @param audio_effect 
+ * @param position layer's first pixel on the strip
+ * @param end one past layer's last pixel on the strip
+ * @param mode 
+ * @param alpha 
+ * @param z_order 
+ */
+void ledStrip::assign_layer(
+        audioMode &audio_effect,
+        CRGB *position,
+        CRGB *end,
+        blend_mode mode,
+        uint8_t alpha,
+        uint8_t z_order)
+{
+    audio_effect.layer_position = position;
+    audio_effect.layer_end = end;
+    audio_effect.layer_blend = mode;
+    audio_effect.layer_alpha = alpha;
+    audio_effect.layer_z = z_order;
+}
+
+/**
+ * @brief Sorts layers by z order, lowest first
+ * 
+ */
+void ledStrip::sort_layers()
+{
+    audioMode *layer = nullptr;
+    uint8_t j = 0;
+
+    for (uint8_t i = 1; i < layer_count; i++)
+    {
+        layer = layers[i];
+        j = i;
+
+        while (j && layers[j - 1]->layer_z > layer->layer_z)
+        {
+            layers[j] = layers[j - 1];
+            j--;
+        }
+
+        layers[j] = layer;
+    }
+}
+
+/**
+ * @brief Replaces an effect with a cross-fade. 
+ *      Both effects run until the incoming one has faded in, 
+ *      after which the outgoing effect is removed.
+ * @note Incoming effect renders to buffer during the fade, which is blended
+ *       in place into outgoing's pixels. No post processing is needed.
+ *       Outgoing pixels which aren't redrawn on a frame fade further towards incoming
+ * 
+ * @param outgoing effect on the strip
+ * @param incoming effect which takes over outgoing's pixels
+ * @param buffer outgoing's size in pixels. Free again after the transition
+ * @param duration_ms 
+ * @return true 
+ * @return false 
+ */
+bool ledStrip::transition(
+        audioMode &outgoing,
+        audioMode &incoming,
+        CRGB *buffer,
+        uint16_t duration_ms)
+{
+    if (transition_in != nullptr)
+    {
+        WARN(F("transition: previous transition finished early"));
+        finish_transition();
+    }
+
+    if (effect_list.find(&outgoing.get_node()) == nullptr)
+    {
+        ERROR(F("transition: outgoing effect isn't on the led strip"));
+        return 1;
+    }
+
+    if (buffer == nullptr)
+    {
+        ERROR(F("transition: nullpointer passed as buffer"));
+        return 1;
+    }
+
+    /* Incoming's buffer maps to outgoing's pixels on the strip, so its changes land there */
+    assign_layer(incoming, outgoing.get_strip_start(), outgoing.get_strip_end(), blend_alpha, 0, outgoing.layer_z);
+
+    if (_add_effect(incoming.get_node(), buffer, buffer + (incoming.layer_end - incoming.layer_position)))
+    {
+        assign_layer(incoming, nullptr, nullptr, blend_replace, 255, 0);
+        return 1;
+    }
+
+    transition_out = &outgoing;
+    transition_in = &incoming;
+    transition_duration_ms = duration_ms;
+    transition_elapsed_us = 0;
+    return 0;
+}
+
+/**
+ * @brief Advances the cross-fade. Alpha is stepped once per frame
+ * 
+ * @param time_delta_us time since the previous frame. Kept in us, so sub-ms frames add up
+ */
+void ledStrip::step_transition(uint32_t time_delta_us)
+{
+    uint32_t elapsed_ms = 0;
+
+    transition_elapsed_us += time_delta_us;
+    elapsed_ms = transition_elapsed_us / 1000;
+
+    if (elapsed_ms >= transition_duration_ms)
+    {
+        finish_transition();
+        return;
+    }
+
+    transition_in->layer_alpha = (elapsed_ms << 8) / transition_duration_ms;
+}
+
+/**
+ * @brief Blends incoming's buffer into outgoing's pixels with the transition's alpha
+ * 
+ */
+void ledStrip::blend_transition()
+{
+    uint16_t size = transition_out->get_strip_end() - transition_out->get_strip_start();
+    uint8_t alpha = transition_in->layer_alpha;
+
+    for (uint16_t i = 0; i < size; i++)
+        blend_pixel(transition_out->get_layer_pixel(i), transition_in->get_layer_pixel(i), blend_alpha, alpha);
+
+    mark_dirty(transition_out->get_strip_start(), transition_out->get_strip_end());
+}
+
+/**
+ * @brief Removes the outgoing effect & moves the incoming one to its place
+ * 
+ */
+void ledStrip::finish_transition()
+{
+    audioMode *incoming = transition_in;
+    audioMode *outgoing = transition_out;
+    CRGB *position = outgoing->get_strip_start();
+    CRGB *end = outgoing->get_strip_end();
+    CRGB *pixels = &outgoing->get_layer_pixel(0);
+    bool was_layer = outgoing->is_layer();
+    blend_mode mode = outgoing->layer_blend;
+    uint8_t alpha = outgoing->layer_alpha;
+    uint8_t z_order = outgoing->layer_z;
+
+    transition_in = nullptr;
+    transition_out = nullptr;
+
+    /* Continue from the faded in pixels */
+    memcpy(pixels, &incoming->get_layer_pixel(0), (end - position) * sizeof(CRGB));
+
+    remove_effect(*outgoing);
+    remove_effect(*incoming);
+
+    /* Incoming takes outgoing's place, in the layer stack if outgoing was a layer */
+    if (was_layer)
+    {
+        add_layer(*incoming, position, end, pixels, mode, z_order, alpha);
+        return;
+    }
+
+    _add_effect(incoming->get_node(), position, end);
+}
+
+/**
+ * @brief Marks effects fully covered by an opaque layer above them as occluded.
+ *      Occluded effects aren't updated or blended.
+ *      Effects rendering straight to the strip are below all layers
+ * 
+ */
+void ledStrip::update_occlusion()
+{
+    sl_list::dl_node<audioMode> *effect_node = effect_list.head();
+    audioMode *effect = nullptr;
+    audioMode *layer = nullptr;
+
+    while (effect_node != nullptr)
+    {
+        effect = effect_node->data;
+        effect_node = effect_list.next(effect_node);
+
+        if (effect == nullptr)
+            continue;
+
+        effect->occluded = 0;
+
+        for (uint8_t i = 0; i < layer_count; i++)
+        {
+            layer = layers[i];
+
+            if (layer == effect || !layer->is_opaque())
+                continue;
+
+            /* Only layers above */
+            if (effect->is_layer() && layer->layer_z <= effect->layer_z)
+                continue;
+
+            if (layer->get_strip_start() <= effect->get_strip_start() &&
+                layer->get_strip_end() >= effect->get_strip_end())
+            {
+                effect->occluded = 1;
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Post processes pixels [start, end) to output in a single pass:
+ *      layer blending, gamma correction, then brightness scaling
+ * 
+ * @tparam GAMMA 1 to apply gamma correction
+ * @tparam COMPOSITE 1 to blend the strip's layers
+ * @param strip 
+ * @param output output buffer
+ * @param start 
+ * @param end 
+ * @param scale brightness
+ */
+template <bool GAMMA, bool COMPOSITE>
+static void post_process_range(
+        ledStrip &strip,
+        CRGB *output,
+        uint16_t start,
+        uint16_t end,
+        uint8_t scale)
+{
+    CRGB pixel;
+    uint8_t r, g, b;
+
+    for (uint16_t i = start; i < end; i++)
+    {
+        pixel = COMPOSITE ? strip.composite_pixel(i) : strip.led_rgb_data[i];
+        r = pixel.r;
+        g = pixel.g;
+        b = pixel.b;
+
+        if (GAMMA)
+        {
+            r = pgm_read_byte(&gamma8_table[r]);
+            g = pgm_read_byte(&gamma8_table[g]);
+            b = pgm_read_byte(&gamma8_table[b]);
+        }
+
+        output[i].r = scale8(r, scale);
+        output[i].g = scale8(g, scale);
+        output[i].b = scale8(b, scale);
+    }
+}
+
+/**
+ * @brief Writes post processed pixels to output_buffer
+ *      for strips with own controller.
+ *      Effects' pixels are left untouched.
+ * @note Brightness, gamma & current limit need it. The buffer doubles the strip's led ram. 
+ *       Disabling it turns them off until it's enabled again
+ * 
+ * @param buffer output buffer. nullptr disables post processing
+ * @param buffer_size at least the led strip's size
+ * @return true 
+ * @return false 
+ */
+bool ledStrip::enable_post_processing(CRGB *buffer, uint16_t buffer_size)
+{
+    if (buffer == nullptr)
+    {
+        if (output_buffer != nullptr && controller != nullptr)
+            controller->setLeds(led_rgb_data, led_rgb_data_size);
+
+        output_buffer = nullptr;
+        mark_dirty(0, led_rgb_data_size);
+        return 0;
+    }
+
+    if (controller == nullptr)
+    {
+        ERROR(F("enable_post_processing: led strip doesn't have own controller"));
+        return 1;
+    }
+
+    if (buffer_size < led_rgb_data_size)
+    {
+        ERROR(F("enable_post_processing: buffer_size: "), buffer_size, F(" smaller than led strip"));
+        return 1;
+    }
+
+    /* FastLED.show() of the strips without own controller pushes this one too */
+    controller->setLeds(buffer, led_rgb_data_size);
+
+    output_buffer = buffer;
+    last_global_brightness = FastLED.getBrightness();
+    mark_dirty(0, led_rgb_data_size);
+    return 0;
+}
+
+/**
+ * @brief Sets the led strip's brightness.
+ *      Applied on top of the global FastLED.setBrightness() 
+ * @note Requires enable_post_processing(). Strips shown with FastLED.show() 
+ *       have no output buffer, use FastLED.setBrightness() for them
+ * 
+ * @param value 
+ * @return true post processing isn't enabled
+ * @return false 
+ */
+bool ledStrip::set_brightness(uint8_t value)
+{
+    if (output_buffer == nullptr && value != 255)
+    {
+        ERROR(F("set_brightness: post processing isn't enabled"));
+        return 1;
+    }
+
+    brightness = value;
+    mark_dirty(0, led_rgb_data_size);
+    return 0;
+}
+
+/**
+ * @brief Enables gamma correction
+ * @note Requires enable_post_processing()
+ * 
+ * @param enable 
+ * @return true post processing isn't enabled
+ * @return false 
+ */
+bool ledStrip::set_gamma_correction(bool enable)
+{
+    if (output_buffer == nullptr && enable)
+    {
+        ERROR(F("set_gamma_correction: post processing isn't enabled"));
+        return 1;
+    }
+
+    gamma_requested = enable;
+    gamma_correction = enable && !reduced_quality;
+    mark_dirty(0, led_rgb_data_size);
+
+    /* Estimate is summed after gamma */
+    if (current_block_sums != nullptr)
+        update_current_estimate(0, led_rgb_data_size);
+
+    return 0;
+}
+
+/**
+ * @brief Suspends the optional post processing features to save time under load.
+ *      Only gamma correction is suspended. Brightness, current limit & layers stay on.
+ *      Set by led_manager's quality governor
+ * 
+ * @param reduce 
+ */
+void ledStrip::set_reduced_quality(bool reduce)
+{
+    if (reduce == reduced_quality)
+        return;
+
+    reduced_quality = reduce;
+
+    if (gamma_requested)
+        set_gamma_correction(gamma_requested);
+}
+
+/**
+ * @brief Limits the led strip's estimated current draw.
+ *      See LED_CHANNEL_MA & LED_IDLE_MA in config.h
+ * @note Requires enable_post_processing(). Strips shown with FastLED.show() 
+ *       use FastLED.setMaxPowerInVoltsAndMilliamps() instead
+ * 
+ * @param limit_ma current budget in mA. 0 disables the limiter
+ * @return true post processing isn't enabled or allocation failed
+ * @return false 
+ */
+bool ledStrip::set_current_limit(uint16_t limit_ma)
+{
+    uint16_t block_count = (led_rgb_data_size + CURRENT_ESTIMATE_BLOCK_SIZE - 1) / CURRENT_ESTIMATE_BLOCK_SIZE;
+
+    if (output_buffer == nullptr && limit_ma)
+    {
+        ERROR(F("set_current_limit: post processing isn't enabled"));
+        return 1;
+    }
+
+    current_limit_ma = limit_ma;
+    mark_dirty(0, led_rgb_data_size);
+
+    if (!limit_ma || current_block_sums != nullptr)
+        return 0;
+
+    current_block_sums = (uint16_t *) malloc(block_count * sizeof(uint16_t));
+
+    if (current_block_sums == nullptr)
+    {
+        ERROR(F("set_current_limit: failed to allocate memory"));
+        current_limit_ma = 0;
+        return 1;
+    }
+
+    for (uint16_t i = 0; i < block_count; i++)
+        current_block_sums[i] = 0;
+
+    channel_sum = 0;
+    update_current_estimate(0, led_rgb_data_size);
+    return 0;
+}
+
+/**
+ * @brief Updates the current estimate for changed pixels [start, end).
+ *      Only the blocks overlapping the range are summed again,
+ *      so unchanged strips cost nothing.
+ * 
+ * @param start 
+ * @param end 
+ */
+void ledStrip::update_current_estimate(uint16_t start, uint16_t end)
+{
+    uint16_t block = start / CURRENT_ESTIMATE_BLOCK_SIZE;
+    uint16_t pixel = block * CURRENT_ESTIMATE_BLOCK_SIZE;
+    uint16_t block_end = 0;
+    uint16_t block_sum = 0;
+    CRGB color;
+
+    if (current_block_sums == nullptr)
+        return;
+
+    if (end > led_rgb_data_size)
+        end = led_rgb_data_size;
+
+    while (pixel < end)
+    {
+        block_end = pixel + CURRENT_ESTIMATE_BLOCK_SIZE;
+
+        if (block_end > led_rgb_data_size)
+            block_end = led_rgb_data_size;
+
+        block_sum = 0;
+
+        for (; pixel < block_end; pixel++)
+        {
+            color = layer_count ? composite_pixel(pixel) : led_rgb_data[pixel];
+
+            if (gamma_correction)
+            {
+                block_sum += pgm_read_byte(&gamma8_table[color.r]);
+                block_sum += pgm_read_byte(&gamma8_table[color.g]);
+                block_sum += pgm_read_byte(&gamma8_table[color.b]);
+                continue;
+            }
+
+            block_sum += (uint16_t) color.r + color.g + color.b;
+        }
+
+        channel_sum += block_sum;
+        channel_sum -= current_block_sums[block];
+        current_block_sums[block] = block_sum;
+        block++;
+    }
+}
+
+/**
+ * @brief Returns the estimated current draw in mA of the last pushed frame
+ * @note Requires set_current_limit()
+ * 
+ * @return uint16_t 
+ */
+uint16_t ledStrip::get_current_estimate()
+{
+    uint32_t channel_ma = channel_sum * output_scale / 255 * LED_CHANNEL_MA / 255;
+
+    return channel_ma + (uint32_t) led_rgb_data_size * LED_IDLE_MA;
+}
+
+/**
+ * @brief Applies gamma, brightness & current limit to the changed pixels
+ *      in one pass over the strip.
+ * @note The limiter's scale is calculated from the cached current estimate
+ *       before the pass. Whole strip is processed only when the scale changes.
+ * 
+ */
+void ledStrip::post_process()
+{
+    uint8_t global_brightness = FastLED.getBrightness();
+    uint8_t scale = scale8(global_brightness, brightness);
+    uint8_t buffer_scale = brightness;
+    uint32_t channel_budget = 0;
+    uint32_t idle_ma = (uint32_t) led_rgb_data_size * LED_IDLE_MA;
+    uint32_t limit = 0;
+
+    if (current_limit_ma)
+    {
+        update_current_estimate(dirty_start, dirty_end);
+
+        if (idle_ma < current_limit_ma)
+            channel_budget = (current_limit_ma - idle_ma) * 255 / LED_CHANNEL_MA;
+
+        /* channel_sum * scale / 255 must fit the budget */
+        if (channel_sum)
+        {
+            limit = channel_budget * 255 / channel_sum;
+
+            if (limit < scale)
+            {
+                scale = limit;
+                buffer_scale = global_brightness ? min((uint16_t) scale * 256 / global_brightness, (uint16_t) brightness) : 0;
+            }
+        }
+    }
+
+    /* The controller applies the global brightness. Buffer holds the rest of the scale */
+    output_scale = scale;
+
+    /* Scale changed. Rewrite the whole output */
+    if (buffer_scale != output_buffer_scale)
+    {
+        output_buffer_scale = buffer_scale;
+        dirty_start = 0;
+        dirty_end = led_rgb_data_size;
+    }
+
+    if (layer_count)
+    {
+        if (gamma_correction)
+            post_process_range<1, 1>(*this, output_buffer, dirty_start, dirty_end, buffer_scale);
+        else
+            post_process_range<0, 1>(*this, output_buffer, dirty_start, dirty_end, buffer_scale);
+
+        return;
+    }
+
+    if (gamma_correction)
+        post_process_range<1, 0>(*this, output_buffer, dirty_start, dirty_end, buffer_scale);
+    else
+        post_process_range<0, 0>(*this, output_buffer, dirty_start, dirty_end, buffer_scale);
 }
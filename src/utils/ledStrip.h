@@ -28,6 +28,7 @@
 #include <inttypes.h>
 #include "../config.h"
 #include "../colorPalettes.h"
+#include "colorMath.h"
 #include "../Audio-modes/audioModes.h"
 #include "data_types/virtual_led_array.h"
 #include "data_types/singly_linked_list.h"
@@ -41,18 +42,180 @@ struct ledStrip
 {
 private:
     bool _add_effect(
-        sl_list::node<audioMode> &effect_node,
+        sl_list::dl_node<audioMode> &effect_node,
         CRGB *pixel_start,
         CRGB *pixel_end);
 
+    /* FastLED controller driving the strip. nullptr when shown with FastLED.show() */
+    CLEDController *controller = nullptr;
+
+    /* Changed pixels [dirty_start, dirty_end) which haven't been pushed to the leds */
+    uint16_t dirty_start = 0;
+    uint16_t dirty_end = 0;
+
+    /* Minimum time between pushes to the leds. 0 pushes on every change */
+    uint32_t show_period_us = 0;
+    uint32_t last_show_time = 0;
+
+    /* Time in us the last show() blocked interrupts. 0 when nothing was pushed */
+    uint16_t last_push_us = 0;
+
+    /* 
+     * Post processing. Output is written to output_buffer, 
+     * so effects' pixels are left untouched. nullptr disables post processing
+     */
+    CRGB *output_buffer = nullptr;
+    uint8_t brightness = 255;
+    bool gamma_correction = 0;
+    uint16_t current_limit_ma = 0;
+
+    /* Gamma correction set by the user. Suspended while reduced_quality is set */
+    bool gamma_requested = 0;
+    bool reduced_quality = 0;
+
+    uint8_t last_global_brightness = 255;
+
+    /* Scale of the pushed frame with the global brightness. Used by the current estimate */
+    uint8_t output_scale = 255;
+
+    /* Scale the output buffer was last written with. The controller applies the global brightness on top */
+    uint8_t output_buffer_scale = 255;
+
+    /* 
+     * Current estimate. Channel sums of CURRENT_ESTIMATE_BLOCK_SIZE pixel blocks, 
+     * after gamma and before brightness. Kept up to date from the changed ranges
+     */
+    uint16_t *current_block_sums = nullptr;
+    uint32_t channel_sum = 0;
+
+    void update_current_estimate(uint16_t start, uint16_t end);
+    void post_process();
+
+    /* Layered effects sorted by z order, lowest first */
+    audioMode *layers[MAX_LAYERS] = {nullptr};
+    uint8_t layer_count = 0;
+
+    void assign_layer(
+        audioMode &audio_effect,
+        CRGB *position,
+        CRGB *end,
+        blend_mode mode,
+        uint8_t alpha,
+        uint8_t z_order);
+
+    void update_occlusion();
+    void sort_layers();
+
+    /* Cross-fade. transition_in's buffer is blended into transition_out's pixels with a growing alpha */
+    audioMode *transition_out = nullptr;
+    audioMode *transition_in = nullptr;
+    uint16_t transition_duration_ms = 0;
+    uint32_t transition_elapsed_us = 0;
+
+    void step_transition(uint32_t time_delta_us);
+    void blend_transition();
+    void finish_transition();
+
 public:
     sl_list::node<ledStrip> ledStrip_node = sl_list::node<ledStrip>(this, nullptr);
-    sl_list::handler<audioMode> effect_list;
+    sl_list::handler<audioMode, sl_list::dl_node<audioMode>> effect_list;
 
     /* Variables to store the physical led strip's pixel values */
     CRGB *led_rgb_data = nullptr;
     uint16_t led_rgb_data_size = 0;
 
+    /**
+     * @brief Returns the strip's own controller, or nullptr when shown with FastLED.show()
+     * 
+     */
+    CLEDController *get_controller() {return controller;}
+
+    /**
+     * @brief Sets the controller which pushes the strip. Set by led_manager::add_led_strip()
+     * 
+     * @param strip_controller nullptr to show with FastLED.show()
+     */
+    void set_controller(CLEDController *strip_controller) {controller = strip_controller;}
+
+    void mark_dirty(uint16_t start, uint16_t end);
+    void mark_dirty(CRGB *start, CRGB *end);
+
+    /**
+     * @brief Returns 1 if the strip has changes that aren't pushed to the leds
+     * 
+     */
+    bool is_dirty() {return dirty_start < dirty_end;}
+
+    /**
+     * @brief Forgets the changed range. Call after pushing the pixels
+     * 
+     */
+    void clear_dirty() {dirty_start = dirty_end = 0;}
+
+    bool set_refresh_rate(uint16_t fps);
+
+    /**
+     * @brief Returns the time in us the last show() blocked interrupts. 0 when nothing was pushed
+     * 
+     */
+    uint16_t get_last_push_us() {return last_push_us;}
+
+    bool enable_post_processing(CRGB *buffer, uint16_t buffer_size);
+    void update_output();
+    bool set_brightness(uint8_t value);
+    bool set_gamma_correction(bool enable);
+    void set_reduced_quality(bool reduce);
+    bool set_current_limit(uint16_t limit_ma);
+    uint16_t get_current_estimate();
+
+    bool show();
+
+    bool add_layer(
+        audioMode &audio_effect,
+        CRGB *pixel_start,
+        CRGB *pixel_end,
+        CRGB *layer_buffer,
+        blend_mode mode,
+        uint8_t z_order,
+        uint8_t alpha = 255);
+
+    bool set_layer(
+        audioMode &audio_effect,
+        blend_mode mode,
+        uint8_t z_order,
+        uint8_t alpha = 255);
+
+    bool transition(
+        audioMode &outgoing,
+        audioMode &incoming,
+        CRGB *buffer,
+        uint16_t duration_ms);
+
+    /**
+     * @brief Returns the pixel with all layers blended on top of it
+     * 
+     * @param i pixel index
+     * @return CRGB 
+     */
+    __attribute__((always_inline)) inline CRGB composite_pixel(uint16_t i)
+    {
+        CRGB pixel = led_rgb_data[i];
+        CRGB *position = &led_rgb_data[i];
+        audioMode *layer = nullptr;
+
+        for (uint8_t l = 0; l < layer_count; l++)
+        {
+            layer = layers[l];
+
+            if (layer->occluded || position < layer->layer_position || position >= layer->layer_end)
+                continue;
+
+            blend_pixel(pixel, layer->get_layer_pixel(position - layer->layer_position), layer->layer_blend, layer->layer_alpha);
+        }
+
+        return pixel;
+    }
+
     bool add_effect(audioMode &audio_effect);
     
     bool add_effect(
@@ -62,7 +225,9 @@ public:
 
     bool remove_effect(audioMode &audio_effect);
 
-    bool update();
+    bool update(const frame_context &context);
+
+    bool dispatch_event(const event &e);
 
     ledStrip() {}
     ~ledStrip();
@@ -0,0 +1,144 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Mikko Johannes Heinänen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "profiler.h"
+#include "debug.h"
+
+#if CONF_ENABLE_PROFILER == 1
+
+profiler_counters profiler;
+
+/**
+ * @brief Adds a measurement to the counter
+ * 
+ * @param time_us 
+ */
+void profile_counter::add(uint32_t time_us)
+{
+    if (time_us > 0xFFFF)
+        time_us = 0xFFFF;
+
+    if (time_us < min_us)
+        min_us = time_us;
+
+    if (time_us > max_us)
+        max_us = time_us;
+
+    /* Keep the average when count would overflow */
+    if (count == 0xFFFF)
+    {
+        total_us >>= 1;
+        count >>= 1;
+    }
+
+    total_us += time_us;
+    count++;
+}
+
+void profile_counter::reset()
+{
+    min_us = 0xFFFF;
+    max_us = 0;
+    total_us = 0;
+    count = 0;
+}
+
+/**
+ * @brief Prints the counter over serial.
+ *      Output example: "frame n: 120 min: 812 avg: 1024 max: 2400 us"
+ * 
+ * @param name 
+ */
+void profile_counter::print(const __FlashStringHelper *name)
+{
+    DEBUG_OUT_NC(name);
+    DEBUG_OUT_NC(F(" n: "));
+    DEBUG_OUT_NC(count);
+
+    if (count)
+    {
+        DEBUG_OUT_NC(F(" min: "));
+        DEBUG_OUT_NC(min_us);
+        DEBUG_OUT_NC(F(" avg: "));
+        DEBUG_OUT_NC(total_us / count);
+        DEBUG_OUT_NC(F(" max: "));
+        DEBUG_OUT_NC(max_us);
+        DEBUG_OUT_NC(F(" us"));
+    }
+
+    DEBUG_OUT(F("\n\r"));
+}
+
+/**
+ * @brief Adds a measurement to the counter & histogram
+ * 
+ * @param time_us 
+ */
+void profile_histogram::add(uint32_t time_us)
+{
+    uint32_t bin = time_us >> PROFILER_HISTOGRAM_SHIFT;
+
+    if (bin >= PROFILER_HISTOGRAM_BINS)
+        bin = PROFILER_HISTOGRAM_BINS - 1;
+
+    if (bins[bin] != 0xFFFF)
+        bins[bin]++;
+
+    profile_counter::add(time_us);
+}
+
+void profile_histogram::reset()
+{
+    for (uint8_t i = 0; i < PROFILER_HISTOGRAM_BINS; i++)
+        bins[i] = 0;
+
+    profile_counter::reset();
+}
+
+/**
+ * @brief Prints the counter and the histogram over serial.
+ *      Histogram line lists upper limit of the bin and its count: "<2048: 10 <4096: 3 ..."
+ * 
+ * @param name 
+ */
+void profile_histogram::print(const __FlashStringHelper *name)
+{
+    profile_counter::print(name);
+
+    for (uint8_t i = 0; i < PROFILER_HISTOGRAM_BINS; i++)
+    {
+        if (i == PROFILER_HISTOGRAM_BINS - 1)
+            DEBUG_OUT_NC(F(" >="));
+        else
+            DEBUG_OUT_NC(F(" <"));
+
+        DEBUG_OUT_NC((uint32_t) (i + (i != PROFILER_HISTOGRAM_BINS - 1)) << PROFILER_HISTOGRAM_SHIFT);
+        DEBUG_OUT_NC(F(": "));
+        DEBUG_OUT_NC(bins[i]);
+    }
+
+    DEBUG_OUT(F("\n\r"));
+}
+
+#endif
@@ -0,0 +1,90 @@
+/*
+ * MIT License
+ *
+ * Copyright (c) 2024 Mikko Johannes Heinänen
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _PROFILER_H_
+#define _PROFILER_H_
+
+#include <Arduino.h>
+#include <inttypes.h>
+#include "../config.h"
+
+#if CONF_ENABLE_PROFILER == 1
+
+/**
+ * @brief Min / avg / max execution time counter
+ * @note Times are measured with micros() (timer0, 4 us resolution).
+ *      Interrupts are disabled during FastLED output, so
+ *      measurements overlapping it may be a few us short.
+ */
+struct profile_counter
+{
+    uint16_t min_us = 0xFFFF;
+    uint16_t max_us = 0;
+    uint32_t total_us = 0;
+    uint16_t count = 0;
+
+    void add(uint32_t time_us);
+    void reset();
+    void print(const __FlashStringHelper *name);
+};
+
+/**
+ * @brief profile_counter with a histogram of the measured times.
+ *      Bin n counts times in [n, n + 1) * 2^PROFILER_HISTOGRAM_SHIFT us.
+ *      Last bin also counts everything above.
+ */
+struct profile_histogram : profile_counter
+{
+    uint16_t bins[PROFILER_HISTOGRAM_BINS] = {0};
+
+    void add(uint32_t time_us);
+    void reset();
+    void print(const __FlashStringHelper *name);
+};
+
+/**
+ * @brief Counters not tied to any effect 
+ * 
+ */
+struct profiler_counters
+{
+    profile_histogram frame;
+    profile_histogram show;
+    profile_counter fft;
+    profile_counter post_process;
+};
+
+extern profiler_counters profiler;
+
+#define PROFILE_START(timestamp) uint32_t timestamp = micros()
+#define PROFILE_END(counter, timestamp) (counter).add(micros() - (timestamp))
+
+#else
+
+#define PROFILE_START(timestamp)
+#define PROFILE_END(counter, timestamp)
+
+#endif /* CONF_ENABLE_PROFILER */
+
+#endif